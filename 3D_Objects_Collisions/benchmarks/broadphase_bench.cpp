@@ -0,0 +1,110 @@
+/*
+Description:
+
+Measures the broad phase against the brute-force search it replaced. The objects are spread
+at random in a box which grows with their number, so every object has about the same number of
+neighbours whatever the count, like the demo with more objects between wider walls.
+For each count it prints the candidate pairs of the grid, the pairs closer than the collision distance
+found by both versions (which must be the same), and the time of one step of each.
+
+Usage : broadphase_bench [largest count], 100000 by default.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <stdint.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/broadphase.hpp>
+#include <common/rng.hpp>
+
+// Collision distance, the diameter of the objects, and the size of the cells.
+#define benchDistance    2.0f
+// Room per object : a cube of this side, so the objects are 3 diameters apart on average.
+#define benchSpacing     6.0f
+// The brute force tests n * (n - 1) / 2 pairs, so it only runs up to this count.
+#define maxBruteForce    20000
+// Steps timed for each count, the time printed is their average.
+#define benchSteps       10
+
+#define benchSeed        20240109u
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The pairs which really touch, in the order they were found.
+static unsigned int countTouching(const std::vector<BodyPair> & pairs, const float * posX, const float * posY, const float * posZ)
+{
+    unsigned int touching = 0;
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        glm::vec3 delta(posX[pairs[p].b] - posX[pairs[p].a], posY[pairs[p].b] - posY[pairs[p].a], posZ[pairs[p].b] - posZ[pairs[p].a]);
+        touching += glm::dot(delta, delta) < benchDistance * benchDistance;
+    }
+    return touching;
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int largest = argc > 1 ? atoi(argv[1]) : 100000;
+
+    printf("%10s %12s %10s %10s %12s %12s %9s\n", "objects", "candidates", "touching", "brute", "grid ms", "brute ms", "speedup");
+    for (unsigned int count = 1000; count <= largest; count *= 10)
+    {
+        float side = benchSpacing * std::cbrt((float)count);
+        glm::vec3 boxMin(-side * 0.5f);
+        glm::vec3 boxMax(side * 0.5f);
+
+        RandomStream random;
+        initRandomStream(random, benchSeed, count);
+        std::vector<float> posX(count), posY(count), posZ(count);
+        fillRandomFloats(random, &posX[0], count, boxMin.x, boxMax.x);
+        fillRandomFloats(random, &posY[0], count, boxMin.y, boxMax.y);
+        fillRandomFloats(random, &posZ[0], count, boxMin.z, boxMax.z);
+
+        SpatialGrid grid;
+        initSpatialGrid(grid, boxMin, boxMax, benchDistance);
+        std::vector<BodyPair> pairs;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int s = 0; s < benchSteps; s++)
+        {
+            findCandidatePairs(grid, &posX[0], &posY[0], &posZ[0], count, pairs);
+        }
+        double gridTime = millisecondsSince(start) / benchSteps;
+        unsigned int touching = countTouching(pairs, &posX[0], &posY[0], &posZ[0]);
+
+        if (count > maxBruteForce)
+        {
+            printf("%10u %12u %10u %10s %12.3f %12s %9s\n", count, (unsigned int)pairs.size(), touching, "-", gridTime, "-", "-");
+            continue;
+        }
+
+        std::vector<BodyPair> brutePairs;
+        int bruteSteps = count > 5000 ? 1 : benchSteps;
+        start = std::chrono::steady_clock::now();
+        for (int s = 0; s < bruteSteps; s++)
+        {
+            findCandidatePairs_slow(&posX[0], &posY[0], &posZ[0], count, benchDistance, brutePairs);
+        }
+        double bruteTime = millisecondsSince(start) / bruteSteps;
+        unsigned int bruteTouching = countTouching(brutePairs, &posX[0], &posY[0], &posZ[0]);
+
+        printf("%10u %12u %10u %10u %12.3f %12.3f %8.1fx\n", count, (unsigned int)pairs.size(), touching, bruteTouching,
+               gridTime, bruteTime, bruteTime / gridTime);
+        if (bruteTouching != touching)
+        {
+            fprintf(stderr, "The grid missed %d touching pairs\n", (int)bruteTouching - (int)touching);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+Description:
+
+Measures cullSpheres(), which tests four bounding spheres against the frustum at once,
+against cullSpheres_slow(), which tests one sphere and one plane at a time. The objects are spread
+at random in a box which grows with their number, and two cameras look at them : one outside the box
+looking at its center, which sees most of them, and one at the center, which sees about one in twenty.
+For each count and camera it prints how many objects are submitted to the draw and how many were culled,
+and the time of one culling pass of each version, which must keep the same objects.
+
+Usage : cull_bench [largest count], 100000 by default.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <stdint.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <common/frustum.hpp>
+#include <common/rng.hpp>
+
+// Radius of the bounding spheres, about suzanne's.
+#define benchRadius      1.4f
+// Room per object : a cube of this side.
+#define benchSpacing     6.0f
+// Culling passes timed for each count are benchPasses / count, at least minPasses. The time printed is their average.
+#define benchPasses      10000000
+#define minPasses        10
+
+#define benchSeed        20240109u
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int largest = argc > 1 ? atoi(argv[1]) : 100000;
+    bool same = true;
+
+    printf("%10s %8s %10s %10s %12s %12s %9s\n", "objects", "camera", "submitted", "culled", "slow ms", "fast ms", "speedup");
+    for (unsigned int count = 1000; count <= largest; count *= 10)
+    {
+        float side = benchSpacing * std::cbrt((float)count);
+
+        // cullSpheres() reads the positions up to count rounded up to 4.
+        unsigned int padded = (count + 3) & ~3u;
+        RandomStream random;
+        initRandomStream(random, benchSeed, count);
+        std::vector<float> posX(padded, 0.0f), posY(padded, 0.0f), posZ(padded, 0.0f);
+        fillRandomFloats(random, &posX[0], count, -side * 0.5f, side * 0.5f);
+        fillRandomFloats(random, &posY[0], count, -side * 0.5f, side * 0.5f);
+        fillRandomFloats(random, &posZ[0], count, -side * 0.5f, side * 0.5f);
+
+        // The projection of controls.cpp, with the far plane past the whole box.
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, side * 3.0f);
+        const char * cameraNames[2] = {"outside", "inside"};
+        glm::mat4 views[2] =
+        {
+            glm::lookAt(glm::vec3(side * 0.6f, side * 0.6f, side * 1.2f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+            glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f))
+        };
+
+        for (int camera = 0; camera < 2; camera++)
+        {
+            Frustum frustum;
+            extractFrustumPlanes(projection * views[camera], frustum);
+
+            std::vector<unsigned int> visible[2];
+            unsigned int visibleCount[2];
+            double times[2];
+            unsigned int passes = benchPasses / count > minPasses ? benchPasses / count : minPasses;
+            for (int version = 0; version < 2; version++)
+            {
+                visible[version].resize(padded);
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (unsigned int p = 0; p < passes; p++)
+                {
+                    if (version == 0)
+                    {
+                        visibleCount[version] = cullSpheres_slow(frustum, &posX[0], &posY[0], &posZ[0], count, benchRadius, &visible[version][0]);
+                    }
+                    else
+                    {
+                        visibleCount[version] = cullSpheres(frustum, &posX[0], &posY[0], &posZ[0], count, benchRadius, &visible[version][0]);
+                    }
+                }
+                times[version] = millisecondsSince(start) / passes;
+                visible[version].resize(visibleCount[version]);
+            }
+
+            bool sameVisible = visible[0] == visible[1];
+            printf("%10u %8s %10u %10u %12.4f %12.4f %8.1fx %s\n", count, cameraNames[camera], visibleCount[1], count - visibleCount[1],
+                   times[0], times[1], times[0] / times[1], sameVisible ? "" : "DIFFERENT");
+            same = sameVisible && same;
+        }
+    }
+
+    if (!same)
+    {
+        fprintf(stderr, "cullSpheres and cullSpheres_slow keep different objects\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+Description:
+
+Measures indexVBO(), which finds the vertices already exported with an open-addressing hash table,
+against the std::map version it replaced, which is kept here as indexVBO_map().
+Both merge the vertices which are equal bit for bit, and must give the same indices and vertices.
+It runs them on suzanne.obj and on generated grids of several sizes, whose inner vertices
+are shared by six triangles like in a real mesh.
+
+Usage : indexer_bench [quads per side of the largest grid], 1000 by default. Run it from tutorial09_vbo_indexing/.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <string.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/objloader.hpp>
+#include <common/vboindexer.hpp>
+
+// Times each indexer runs on a mesh, the time printed is their average. Meshes of more than
+// singleRunCorners corners take seconds with std::map, so they are indexed once.
+#define benchRuns        5
+#define singleRunCorners 1000000
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The vertex as the std::map version compared it : its raw bytes.
+struct MapVertex
+{
+    glm::vec3 position;
+    glm::vec2 uv;
+    glm::vec3 normal;
+    bool operator<(const MapVertex & that) const
+    {
+        return memcmp(this, &that, sizeof(MapVertex)) > 0;
+    }
+};
+
+// indexVBO() before the hash table : a std::map from the vertex to its index, with one node per vertex.
+static void indexVBO_map(
+    std::vector<glm::vec3> & in_vertices,
+    std::vector<glm::vec2> & in_uvs,
+    std::vector<glm::vec3> & in_normals,
+
+    std::vector<unsigned int> & out_indices,
+    std::vector<glm::vec3> & out_vertices,
+    std::vector<glm::vec2> & out_uvs,
+    std::vector<glm::vec3> & out_normals
+){
+    std::map<MapVertex, unsigned int> VertexToOutIndex;
+    for (unsigned int i = 0; i < in_vertices.size(); i++)
+    {
+        MapVertex packed = {in_vertices[i], in_uvs[i], in_normals[i]};
+        std::map<MapVertex, unsigned int>::iterator it = VertexToOutIndex.find(packed);
+        if (it != VertexToOutIndex.end())
+        {
+            out_indices.push_back(it->second);
+        }
+        else
+        {
+            out_vertices.push_back(in_vertices[i]);
+            out_uvs.push_back(in_uvs[i]);
+            out_normals.push_back(in_normals[i]);
+            unsigned int newindex = out_vertices.size() - 1;
+            out_indices.push_back(newindex);
+            VertexToOutIndex[packed] = newindex;
+        }
+    }
+}
+
+// A flat grid of size x size quads, two triangles each, with the corners of every triangle listed.
+static void generateGrid(int size, std::vector<glm::vec3> & out_vertices, std::vector<glm::vec2> & out_uvs,
+                         std::vector<glm::vec3> & out_normals)
+{
+    const int corners[6][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}};
+    out_vertices.clear();
+    out_uvs.clear();
+    out_normals.clear();
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            for (int c = 0; c < 6; c++)
+            {
+                float u = (float)(x + corners[c][0]) / size;
+                float v = (float)(y + corners[c][1]) / size;
+                out_vertices.push_back(glm::vec3(u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.0f));
+                out_uvs.push_back(glm::vec2(u, v));
+                out_normals.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+            }
+        }
+    }
+}
+
+// Runs both indexers on the mesh, prints their times, and returns false if their results differ.
+static bool compareIndexers(const char * name, std::vector<glm::vec3> & vertices, std::vector<glm::vec2> & uvs,
+                            std::vector<glm::vec3> & normals)
+{
+    std::vector<unsigned int> indices[2];
+    std::vector<glm::vec3> outVertices[2], outNormals[2];
+    std::vector<glm::vec2> outUvs[2];
+    double times[2];
+    int runs = vertices.size() > singleRunCorners ? 1 : benchRuns;
+    for (int version = 0; version < 2; version++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int r = 0; r < runs; r++)
+        {
+            indices[version].clear();
+            outVertices[version].clear();
+            outUvs[version].clear();
+            outNormals[version].clear();
+            if (version == 0)
+            {
+                indexVBO_map(vertices, uvs, normals, indices[version], outVertices[version], outUvs[version], outNormals[version]);
+            }
+            else
+            {
+                indexVBO(vertices, uvs, normals, indices[version], outVertices[version], outUvs[version], outNormals[version]);
+            }
+        }
+        times[version] = millisecondsSince(start) / runs;
+    }
+
+    bool same = indices[0] == indices[1] && outVertices[0] == outVertices[1] && outUvs[0] == outUvs[1] && outNormals[0] == outNormals[1];
+    printf("%-16s %10u %10u %12.3f %12.3f %8.1fx %s\n", name, (unsigned int)vertices.size(), (unsigned int)outVertices[1].size(),
+           times[0], times[1], times[0] / times[1], same ? "" : "DIFFERENT");
+    return same;
+}
+
+int main(int argc, char * argv[])
+{
+    int largest = argc > 1 ? atoi(argv[1]) : 1000;
+    bool same = true;
+
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    bool loaded = loadOBJ("suzanne.obj", vertices, uvs, normals);
+
+    printf("%-16s %10s %10s %12s %12s %9s\n", "mesh", "corners", "vertices", "std::map ms", "hash ms", "speedup");
+    if (loaded)
+    {
+        same = compareIndexers("suzanne.obj", vertices, uvs, normals) && same;
+    }
+
+    for (int size = 10; size <= largest; size *= 10)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "grid %dx%d", size, size);
+        generateGrid(size, vertices, uvs, normals);
+        same = compareIndexers(name, vertices, uvs, normals) && same;
+    }
+
+    if (!same)
+    {
+        fprintf(stderr, "indexVBO and the std::map version differ\n");
+        return 1;
+    }
+    return 0;
+}
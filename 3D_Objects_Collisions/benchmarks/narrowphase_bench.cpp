@@ -0,0 +1,173 @@
+/*
+Description:
+
+Measures the narrow phase run by the threads of a TaskPool, resolve*ContactsParallel(), against
+resolve*Contacts(), which resolves one pair after the other on the calling thread, for the three shapes :
+spheres, the oriented box of suzanne.obj, and its mesh tested with the BVH. The objects are suzannes
+packed at random in a box, so the spheres around a sixth of the candidate pairs overlap.
+For each count and shape it prints the candidate pairs, the touching pairs found by each version and the time
+of one step of each. Both start from the same objects, but the versions resolve the pairs in different orders,
+so the touching pairs can differ a little.
+
+Usage : narrowphase_bench [largest count] [threads], 10000 objects and one thread per core by default.
+Run it from tutorial09_vbo_indexing/.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <thread>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <stdint.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <common/objloader.hpp>
+#include <common/vboindexer.hpp>
+#include <common/taskpool.hpp>
+#include <common/meshbvh.hpp>
+#include <common/frustum.hpp>
+#include <common/obb.hpp>
+#include <common/broadphase.hpp>
+#include <common/bodystore.hpp>
+#include <common/narrowphase.hpp>
+#include <common/rng.hpp>
+
+// Room per object : a cube of this side, a little less than the diameter of suzanne's bounding sphere.
+#define benchSpacing     2.6f
+#define benchRestitution 1.0f
+// Steps timed for each count and shape, the time printed is their average. Each starts from the same objects.
+#define benchSteps       5
+
+#define benchSeed        20240109u
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The collision shape of the demo.
+struct BenchShape
+{
+    OrientedBox box;
+    MeshBvh bvh;
+    float radius;
+};
+
+// Resolves the pairs with one shape, serially when pool is NULL.
+static unsigned int resolveContacts(TaskPool * pool, int shape, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                    const BenchShape & benchShape)
+{
+    if (shape == 0)
+    {
+        float distance = 2.0f * benchShape.radius;
+        return pool ? resolveSphereContactsParallel(*pool, bodies, pairs, distance, benchRestitution)
+                    : resolveSphereContacts(bodies, pairs, distance, benchRestitution);
+    }
+    if (shape == 1)
+    {
+        return pool ? resolveBoxContactsParallel(*pool, bodies, pairs, benchShape.box, benchShape.radius, benchRestitution)
+                    : resolveBoxContacts(bodies, pairs, benchShape.box, benchShape.radius, benchRestitution);
+    }
+    return pool ? resolveMeshContactsParallel(*pool, bodies, pairs, benchShape.box, benchShape.bvh, benchShape.radius, benchRestitution)
+                : resolveMeshContacts(bodies, pairs, benchShape.box, benchShape.bvh, benchShape.radius, benchRestitution);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int largest = argc > 1 ? atoi(argv[1]) : 10000;
+    unsigned int threadCount = argc > 2 ? atoi(argv[2]) : 0;
+
+    TaskPool pool;
+    startTaskPool(pool, threadCount);
+
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    if (!loadOBJ("suzanne.obj", vertices, uvs, normals))
+    {
+        fprintf(stderr, "Failed to load suzanne.obj, run narrowphase_bench from tutorial09_vbo_indexing/\n");
+        stopTaskPool(pool);
+        return 1;
+    }
+    std::vector<unsigned int> indices;
+    std::vector<InterleavedVertex> interleaved;
+    indexVBO_interleaved(vertices, uvs, normals, indices, interleaved);
+    std::vector<BvhNode> bvhNodes;
+    std::vector<BvhTriangle> bvhTriangles;
+    buildMeshBvh(pool, &interleaved[0], sizeof(InterleavedVertex), &indices[0], indices.size(), bvhNodes, bvhTriangles);
+
+    BenchShape benchShape;
+    benchShape.box = computeMeshOBB(&interleaved[0], sizeof(InterleavedVertex), interleaved.size());
+    benchShape.bvh = getMeshBvh(bvhNodes, bvhTriangles);
+    benchShape.radius = computeBoundingRadius(&interleaved[0], sizeof(InterleavedVertex), interleaved.size());
+
+    const char * shapeNames[3] = {"sphere", "box", "mesh"};
+    printf("%u threads\n", (unsigned int)pool.threads.size() + 1);
+    printf("%10s %8s %12s %10s %10s %12s %12s %9s\n", "objects", "shape", "candidates", "serial", "parallel",
+           "serial ms", "parallel ms", "speedup");
+    for (unsigned int count = 1000; count <= largest; count *= 10)
+    {
+        float side = benchSpacing * std::cbrt((float)count);
+        glm::vec3 boxMin(-side * 0.5f);
+        glm::vec3 boxMax(side * 0.5f);
+
+        RandomStream random;
+        initRandomStream(random, benchSeed, count);
+        BodyStore initial;
+        initBodyStore(initial, count);
+        fillRandomFloats(random, initial.posX, count, boxMin.x, boxMax.x);
+        fillRandomFloats(random, initial.posY, count, boxMin.y, boxMax.y);
+        fillRandomFloats(random, initial.posZ, count, boxMin.z, boxMax.z);
+        fillRandomFloats(random, initial.velX, count, -0.05f, 0.05f);
+        fillRandomFloats(random, initial.velY, count, -0.05f, 0.05f);
+        fillRandomFloats(random, initial.velZ, count, -0.05f, 0.05f);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            initial.invMass[i] = 1.0f;
+            glm::quat orientation(nextRandomFloat(random, -1.0f, 1.0f), nextRandomFloat(random, -1.0f, 1.0f),
+                                  nextRandomFloat(random, -1.0f, 1.0f), nextRandomFloat(random, -1.0f, 1.0f));
+            setBodyOrientation(initial, i, glm::normalize(orientation));
+        }
+
+        SpatialGrid grid;
+        initSpatialGrid(grid, boxMin, boxMax, 2.0f * benchShape.radius);
+        std::vector<BodyPair> pairs;
+        findCandidatePairs(grid, initial.posX, initial.posY, initial.posZ, count, pairs);
+
+        for (int shape = 0; shape < 3; shape++)
+        {
+            BodyStore bodies;
+            initBodyStore(bodies, count);
+            unsigned int touching[2];
+            double times[2];
+            for (int version = 0; version < 2; version++)
+            {
+                times[version] = 0.0;
+                for (int s = 0; s < benchSteps; s++)
+                {
+                    copyBodyStore(bodies, initial);
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    touching[version] = resolveContacts(version == 0 ? NULL : &pool, shape, bodies, pairs, benchShape);
+                    times[version] += millisecondsSince(start);
+                }
+                times[version] /= benchSteps;
+            }
+            printf("%10u %8s %12u %10u %10u %12.3f %12.3f %8.1fx\n", count, shapeNames[shape], (unsigned int)pairs.size(),
+                   touching[0], touching[1], times[0], times[1], times[0] / times[1]);
+        }
+    }
+
+    stopTaskPool(pool);
+    return 0;
+}
@@ -0,0 +1,229 @@
+/*
+Description:
+
+Measures loadOBJ(), which maps the file and parses it in place, against the fscanf loader it replaced,
+which is kept here as loadOBJ_fscanf(). It writes .obj files of several sizes, a bumpy grid with
+positions, UVs and normals like an exported mesh, loads each one with both loaders, checks that
+they read the same values and deletes the file.
+
+Usage : objloader_bench [triangles of the largest mesh], 1000000 by default.
+The files are written in the current directory.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <string.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/objloader.hpp>
+
+// Times each loader reads a file, the time printed is their average.
+#define benchRuns 3
+
+// One line of the table, which is printed at the end since loadOBJ() prints the files it loads.
+struct BenchResult
+{
+    unsigned int triangles;
+    double megabytes;
+    double times[2];
+    bool same;
+};
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// loadOBJ() before the mapped parser : one fscanf per token.
+static bool loadOBJ_fscanf(
+    const char * path,
+    std::vector<glm::vec3> & out_vertices,
+    std::vector<glm::vec2> & out_uvs,
+    std::vector<glm::vec3> & out_normals
+){
+    std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
+    std::vector<glm::vec3> temp_vertices;
+    std::vector<glm::vec2> temp_uvs;
+    std::vector<glm::vec3> temp_normals;
+
+    FILE * file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        char lineHeader[128];
+        if (fscanf(file, "%127s", lineHeader) == EOF)
+        {
+            break;
+        }
+
+        if (strcmp(lineHeader, "v") == 0)
+        {
+            glm::vec3 vertex;
+            fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
+            temp_vertices.push_back(vertex);
+        }
+        else if (strcmp(lineHeader, "vt") == 0)
+        {
+            glm::vec2 uv;
+            fscanf(file, "%f %f\n", &uv.x, &uv.y);
+            uv.y = -uv.y;
+            temp_uvs.push_back(uv);
+        }
+        else if (strcmp(lineHeader, "vn") == 0)
+        {
+            glm::vec3 normal;
+            fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
+            temp_normals.push_back(normal);
+        }
+        else if (strcmp(lineHeader, "f") == 0)
+        {
+            unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
+            int matches = fscanf(file, "%u/%u/%u %u/%u/%u %u/%u/%u\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0],
+                                 &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
+            if (matches != 9)
+            {
+                fclose(file);
+                return false;
+            }
+            for (int c = 0; c < 3; c++)
+            {
+                vertexIndices.push_back(vertexIndex[c]);
+                uvIndices.push_back(uvIndex[c]);
+                normalIndices.push_back(normalIndex[c]);
+            }
+        }
+        else
+        {
+            char buffer[1000];
+            fgets(buffer, sizeof(buffer), file);
+        }
+    }
+    fclose(file);
+
+    for (unsigned int i = 0; i < vertexIndices.size(); i++)
+    {
+        out_vertices.push_back(temp_vertices[vertexIndices[i] - 1]);
+        out_uvs.push_back(temp_uvs[uvIndices[i] - 1]);
+        out_normals.push_back(temp_normals[normalIndices[i] - 1]);
+    }
+    return true;
+}
+
+// Writes a grid of size x size quads, two triangles each, whose height is a few waves.
+static bool writeGridOBJ(const char * path, int size)
+{
+    FILE * file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+    fprintf(file, "# Generated by objloader_bench\no grid\n");
+    for (int y = 0; y <= size; y++)
+    {
+        for (int x = 0; x <= size; x++)
+        {
+            float u = (float)x / size;
+            float v = (float)y / size;
+            float height = 0.1f * std::sin(u * 25.0f) * std::cos(v * 17.0f);
+            glm::vec3 normal = glm::normalize(glm::vec3(-2.5f * std::cos(u * 25.0f) * std::cos(v * 17.0f),
+                                                        1.7f * std::sin(u * 25.0f) * std::sin(v * 17.0f), 1.0f));
+            fprintf(file, "v %f %f %f\n", u * 20.0f - 10.0f, v * 20.0f - 10.0f, height);
+            fprintf(file, "vt %f %f\n", u, v);
+            fprintf(file, "vn %f %f %f\n", normal.x, normal.y, normal.z);
+        }
+    }
+    fprintf(file, "s off\n");
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            int a = y * (size + 1) + x + 1;
+            int b = a + 1;
+            int c = a + size + 2;
+            int d = a + size + 1;
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c);
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, d, d, d);
+        }
+    }
+    return fclose(file) == 0;
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int largest = argc > 1 ? atoi(argv[1]) : 1000000;
+    std::vector<BenchResult> results;
+
+    for (unsigned int triangles = 10000; triangles <= largest; triangles *= 10)
+    {
+        int size = (int)std::sqrt(triangles / 2.0);
+        char path[64];
+        snprintf(path, sizeof(path), "objloader_bench_%u.obj", triangles);
+        if (!writeGridOBJ(path, size))
+        {
+            fprintf(stderr, "Can't write %s\n", path);
+            return 1;
+        }
+
+        std::vector<glm::vec3> vertices[2], normals[2];
+        std::vector<glm::vec2> uvs[2];
+        BenchResult result;
+        bool loaded = true;
+        for (int version = 0; version < 2; version++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int r = 0; r < benchRuns; r++)
+            {
+                vertices[version].clear();
+                uvs[version].clear();
+                normals[version].clear();
+                if (version == 0)
+                {
+                    loaded = loadOBJ_fscanf(path, vertices[version], uvs[version], normals[version]) && loaded;
+                }
+                else
+                {
+                    loaded = loadOBJ(path, vertices[version], uvs[version], normals[version]) && loaded;
+                }
+            }
+            result.times[version] = millisecondsSince(start) / benchRuns;
+        }
+
+        FILE * file = fopen(path, "rb");
+        fseek(file, 0, SEEK_END);
+        result.megabytes = ftell(file) / (1024.0 * 1024.0);
+        fclose(file);
+        remove(path);
+
+        result.triangles = 2 * size * size;
+        result.same = loaded && vertices[0] == vertices[1] && uvs[0] == uvs[1] && normals[0] == normals[1];
+        results.push_back(result);
+    }
+
+    bool same = true;
+    printf("%12s %10s %12s %12s %9s\n", "triangles", "MB", "fscanf ms", "mapped ms", "speedup");
+    for (unsigned int i = 0; i < results.size(); i++)
+    {
+        const BenchResult & result = results[i];
+        printf("%12u %10.1f %12.3f %12.3f %8.1fx %s\n", result.triangles, result.megabytes, result.times[0], result.times[1],
+               result.times[0] / result.times[1], result.same ? "" : "DIFFERENT");
+        same = result.same && same;
+    }
+
+    if (!same)
+    {
+        fprintf(stderr, "loadOBJ and the fscanf version read different values\n");
+        return 1;
+    }
+    return 0;
+}
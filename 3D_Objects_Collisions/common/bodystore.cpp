@@ -0,0 +1,255 @@
+/*
+Description:
+
+This file stores the attributes of the objects as a structure of arrays.
+Each attribute of all objects is one contiguous, aligned and padded array, 
+so the wall clamp and the integration are plain loops over floats which 
+the compiler turns into SIMD instructions (SSE/AVX on x86, NEON on the M2).
+
+*/
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "bodystore.hpp"
+
+// Number of float arrays in a BodyStore.
+#define bodyArrayCount 14
+
+#if defined(_MSC_VER)
+#define RESTRICT __restrict
+#else
+#define RESTRICT __restrict__
+#endif
+
+static void bodyArrays(const BodyStore & bodies, float ** arrays)
+{
+    arrays[0] = bodies.posX;
+    arrays[1] = bodies.posY;
+    arrays[2] = bodies.posZ;
+    arrays[3] = bodies.velX;
+    arrays[4] = bodies.velY;
+    arrays[5] = bodies.velZ;
+    arrays[6] = bodies.rotW;
+    arrays[7] = bodies.rotX;
+    arrays[8] = bodies.rotY;
+    arrays[9] = bodies.rotZ;
+    arrays[10] = bodies.rotSpeedX;
+    arrays[11] = bodies.rotSpeedY;
+    arrays[12] = bodies.rotSpeedZ;
+    arrays[13] = bodies.invMass;
+}
+
+void initBodyStore(BodyStore & bodies, int count)
+{
+    bodies.count = count;
+    bodies.paddedCount = (count + bodyLanes - 1) / bodyLanes * bodyLanes;
+
+    // Allocate one more alignment's worth of floats, then start at the first aligned address.
+    int alignFloats = bodyAlignment / sizeof(float);
+    bodies.storage.assign(bodyArrayCount * bodies.paddedCount + alignFloats, 0.0f);
+    uintptr_t address = (uintptr_t)&bodies.storage[0];
+    float * base = &bodies.storage[0] + ((bodyAlignment - address % bodyAlignment) % bodyAlignment) / sizeof(float);
+
+    float ** fields[bodyArrayCount] =
+    {
+        &bodies.posX, &bodies.posY, &bodies.posZ,
+        &bodies.velX, &bodies.velY, &bodies.velZ,
+        &bodies.rotW, &bodies.rotX, &bodies.rotY, &bodies.rotZ,
+        &bodies.rotSpeedX, &bodies.rotSpeedY, &bodies.rotSpeedZ,
+        &bodies.invMass
+    };
+    for (int f = 0; f < bodyArrayCount; f++)
+    {
+        *fields[f] = base + f * bodies.paddedCount;
+    }
+
+    // The padding too : a zero quaternion can't be normalized.
+    std::fill(bodies.rotW, bodies.rotW + bodies.paddedCount, 1.0f);
+
+    bodies.intStorage.assign(3 * bodies.paddedCount, 0);
+    bodies.wallContact = &bodies.intStorage[0];
+    bodies.restSteps = &bodies.intStorage[bodies.paddedCount];
+    bodies.asleep = &bodies.intStorage[2 * bodies.paddedCount];
+}
+
+void copyBodyStore(BodyStore & dst, const BodyStore & src)
+{
+    float * dstArrays[bodyArrayCount];
+    float * srcArrays[bodyArrayCount];
+    bodyArrays(dst, dstArrays);
+    bodyArrays(src, srcArrays);
+
+    for (int f = 0; f < bodyArrayCount; f++)
+    {
+        std::copy(srcArrays[f], srcArrays[f] + src.paddedCount, dstArrays[f]);
+    }
+    std::copy(src.intStorage.begin(), src.intStorage.end(), dst.intStorage.begin());
+}
+
+// Clamps one axis and or-s contactBit into contact for the objects touching a wall.
+static void clampAxis(float * RESTRICT pos, float * RESTRICT vel, int * RESTRICT contact, int n,
+                      float wallMin, float wallMax, float restitution, bool touchOnMin, int contactBit)
+{
+    for (int i = 0; i < n; i++)
+    {
+        float p = pos[i];
+        float v = vel[i];
+
+        // Touching the wall changes the rotation, being past it also bounces the object back.
+        // Written without branches (| instead of ||) so that the loop vectorizes.
+        int touched = (touchOnMin ? (p <= wallMin) : (p < wallMin)) | (p >= wallMax);
+        bool below = p < wallMin;
+        bool above = p >= wallMax;
+        v = below ? std::fabs(v) * restitution : v;
+        v = above ? -std::fabs(v) * restitution : v;
+
+        // The part of the step past the wall is done in the other direction, as if the object
+        // had bounced at the moment it reached the wall. The clamp only matters for a step longer than the box.
+        p = below ? 2.0f * wallMin - p : p;
+        p = above ? 2.0f * wallMax - p : p;
+
+        pos[i] = std::min(std::max(p, wallMin), wallMax);
+        vel[i] = v;
+        contact[i] |= touched * contactBit;
+    }
+}
+
+void clampBodiesToWalls(BodyStore & bodies, glm::vec3 wallMin, glm::vec3 wallMax, float restitution)
+{
+    int n = bodies.paddedCount;
+
+    std::fill(bodies.wallContact, bodies.wallContact + n, 0);
+    clampAxis(bodies.posX, bodies.velX, bodies.wallContact, n, wallMin.x, wallMax.x, restitution, true, wallContactX);
+    clampAxis(bodies.posY, bodies.velY, bodies.wallContact, n, wallMin.y, wallMax.y, restitution, true, wallContactY);
+    clampAxis(bodies.posZ, bodies.velZ, bodies.wallContact, n, wallMin.z, wallMax.z, restitution, false, wallContactZ);
+}
+
+// Adds one step of speed to value for every object.
+static void integrateArray(float * RESTRICT value, const float * RESTRICT speed, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        value[i] += speed[i];
+    }
+}
+
+// Turns orientation i by its angular velocity : q = q * (rotation of |w| about w / |w|).
+// The angular velocity is in the object's frame, so it multiplies on the right.
+// The product is renormalized, so the rounding errors of the steps don't build up.
+static inline void integrateBodyRotation(BodyStore & bodies, int i)
+{
+    float wx = bodies.rotSpeedX[i];
+    float wy = bodies.rotSpeedY[i];
+    float wz = bodies.rotSpeedZ[i];
+    float qw = bodies.rotW[i];
+    float qx = bodies.rotX[i];
+    float qy = bodies.rotY[i];
+    float qz = bodies.rotZ[i];
+
+    // sin(angle / 2) / angle tends to 1/2 for small angles, which also covers the objects that don't turn.
+    float angle = std::sqrt(wx * wx + wy * wy + wz * wz);
+    float s = angle > 1e-6f ? std::sin(0.5f * angle) / angle : 0.5f;
+    float dw = std::cos(0.5f * angle);
+    float dx = wx * s;
+    float dy = wy * s;
+    float dz = wz * s;
+
+    float w = qw * dw - qx * dx - qy * dy - qz * dz;
+    float x = qw * dx + qx * dw + qy * dz - qz * dy;
+    float y = qw * dy - qx * dz + qy * dw + qz * dx;
+    float z = qw * dz + qx * dy - qy * dx + qz * dw;
+
+    float inverseLength = 1.0f / std::sqrt(w * w + x * x + y * y + z * z);
+    bodies.rotW[i] = w * inverseLength;
+    bodies.rotX[i] = x * inverseLength;
+    bodies.rotY[i] = y * inverseLength;
+    bodies.rotZ[i] = z * inverseLength;
+}
+
+void integrateBodyRotations(BodyStore & bodies)
+{
+    for (int i = 0; i < bodies.paddedCount; i++)
+    {
+        integrateBodyRotation(bodies, i);
+    }
+}
+
+void integrateBodyRotations(BodyStore & bodies, const std::vector<unsigned int> & awake)
+{
+    for (unsigned int a = 0; a < awake.size(); a++)
+    {
+        integrateBodyRotation(bodies, awake[a]);
+    }
+}
+
+void integrateBodies(BodyStore & bodies)
+{
+    int n = bodies.paddedCount;
+
+    integrateBodyRotations(bodies);
+
+    integrateArray(bodies.posX, bodies.velX, n);
+    integrateArray(bodies.posY, bodies.velY, n);
+    integrateArray(bodies.posZ, bodies.velZ, n);
+}
+
+// out = a + (b - a) * alpha for every object.
+static void interpolateArray(float * RESTRICT out, const float * RESTRICT a, const float * RESTRICT b, int n, float alpha)
+{
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = a[i] + (b[i] - a[i]) * alpha;
+    }
+}
+
+void interpolateBodies(BodyStore & out, const BodyStore & previous, const BodyStore & current, float alpha)
+{
+    int n = current.paddedCount;
+
+    interpolateArray(out.posX, previous.posX, current.posX, n, alpha);
+    interpolateArray(out.posY, previous.posY, current.posY, n, alpha);
+    interpolateArray(out.posZ, previous.posZ, current.posZ, n, alpha);
+
+    for (int i = 0; i < current.count; i++)
+    {
+        setBodyOrientation(out, i, glm::slerp(getBodyOrientation(previous, i), getBodyOrientation(current, i), alpha));
+    }
+}
+
+glm::vec3 getBodyPosition(const BodyStore & bodies, int i)
+{
+    return glm::vec3(bodies.posX[i], bodies.posY[i], bodies.posZ[i]);
+}
+
+glm::quat getBodyOrientation(const BodyStore & bodies, int i)
+{
+    return glm::quat(bodies.rotW[i], bodies.rotX[i], bodies.rotY[i], bodies.rotZ[i]);
+}
+
+void setBodyOrientation(BodyStore & bodies, int i, glm::quat orientation)
+{
+    bodies.rotW[i] = orientation.w;
+    bodies.rotX[i] = orientation.x;
+    bodies.rotY[i] = orientation.y;
+    bodies.rotZ[i] = orientation.z;
+}
+
+// The rotation of the quaternion in the upper 3x3, the position in the last column.
+glm::mat4 getBodyModelMatrix(const BodyStore & bodies, int i)
+{
+    glm::mat4 ModelMatrix = glm::mat4_cast(getBodyOrientation(bodies, i));
+    ModelMatrix[3] = glm::vec4(getBodyPosition(bodies, i), 1.0f);
+    return ModelMatrix;
+}
+
+glm::mat3 getBodyRotation(const BodyStore & bodies, int i)
+{
+    return glm::mat3_cast(getBodyOrientation(bodies, i));
+}
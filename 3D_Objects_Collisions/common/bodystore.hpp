@@ -0,0 +1,84 @@
+#ifndef BODYSTORE_HPP
+#define BODYSTORE_HPP
+
+// Every array is aligned on bodyAlignment bytes and padded to a multiple of bodyLanes floats,
+// so the passes below can run over whole SIMD registers without a remainder loop.
+#define bodyAlignment 64
+#define bodyLanes     16
+
+// Bits of wallContact : which walls the object touched during the last clampBodiesToWalls().
+#define wallContactX 1
+#define wallContactY 2
+#define wallContactZ 4
+
+// Structure-of-arrays storage of the objects : one contiguous array per attribute.
+// Velocities are in world units per step. The orientation is a unit quaternion (rotW, rotX, rotY, rotZ),
+// and the rotation speed is an angular velocity about the object's own axes, in radians per step.
+// invMass is 1 / mass. 0 is an object nothing can move, which is also what the padding holds.
+// A sleeping object has no speed and is skipped by the simulation until something hits it, see sleep.hpp.
+// The pointers point into storage and intStorage, so a copy would still point into the original :
+// copying is disabled, copyBodyStore() copies the values instead.
+struct BodyStore
+{
+    BodyStore() {}
+    BodyStore(const BodyStore &) = delete;
+    BodyStore & operator=(const BodyStore &) = delete;
+
+    int count;
+    int paddedCount;
+    std::vector<float> storage;
+    std::vector<int> intStorage;
+
+    float * posX;
+    float * posY;
+    float * posZ;
+    float * velX;
+    float * velY;
+    float * velZ;
+    float * rotW;
+    float * rotX;
+    float * rotY;
+    float * rotZ;
+    float * rotSpeedX;
+    float * rotSpeedY;
+    float * rotSpeedZ;
+    float * invMass;
+    int * wallContact;
+    int * restSteps;    // steps since the object was last faster than the sleep speed
+    int * asleep;
+};
+
+// Allocates the arrays for count objects, all attributes set to 0 but the orientations, which are the identity.
+void initBodyStore(BodyStore & bodies, int count);
+
+// Copies every attribute of src into dst. Both must hold the same number of objects.
+void copyBodyStore(BodyStore & dst, const BodyStore & src);
+
+// Keeps the objects inside the walls : an object past a wall is mirrored back by as much as it went past it,
+// and its speed along that axis is reflected and scaled by restitution (1 keeps all of it).
+// The touched walls are written to wallContact.
+void clampBodiesToWalls(BodyStore & bodies, glm::vec3 wallMin, glm::vec3 wallMax, float restitution);
+
+// Moves and rotates all objects by one step.
+void integrateBodies(BodyStore & bodies);
+
+// Only rotates them, for when sweepBodies() moves them.
+void integrateBodyRotations(BodyStore & bodies);
+
+// Only rotates the objects listed in awake. The others must not turn, like the sleeping objects of sleep.hpp.
+void integrateBodyRotations(BodyStore & bodies, const std::vector<unsigned int> & awake);
+
+// Blends two states of the same objects for rendering : alpha = 0 gives "previous", alpha = 1 gives "current".
+// Orientations are blended along the shorter arc (slerp).
+void interpolateBodies(BodyStore & out, const BodyStore & previous, const BodyStore & current, float alpha);
+
+// Adapters for the renderer.
+glm::vec3 getBodyPosition(const BodyStore & bodies, int i);
+glm::quat getBodyOrientation(const BodyStore & bodies, int i);
+void setBodyOrientation(BodyStore & bodies, int i, glm::quat orientation);
+glm::mat4 getBodyModelMatrix(const BodyStore & bodies, int i);
+
+// The rotation part of getBodyModelMatrix(), for the narrow phase.
+glm::mat3 getBodyRotation(const BodyStore & bodies, int i);
+
+#endif
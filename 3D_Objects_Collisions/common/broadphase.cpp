@@ -0,0 +1,159 @@
+/*
+Description:
+
+This file is the broad phase of the collision detection.
+The box bounded by the walls is split into cubic cells, the bodies are sorted by cell,
+and only bodies in the same or in neighbouring cells are reported as candidate pairs.
+This replaces testing every pair of bodies, so the cost grows with the number of bodies
+instead of its square.
+
+*/
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "broadphase.hpp"
+
+// Half of the 26 neighbouring cells. The other half is visited from the neighbour's side,
+// so each pair of cells is only looked at once.
+static const int forwardNeighbours[13][3] =
+{
+    { 1, -1, -1}, { 1, -1,  0}, { 1, -1,  1},
+    { 1,  0, -1}, { 1,  0,  0}, { 1,  0,  1},
+    { 1,  1, -1}, { 1,  1,  0}, { 1,  1,  1},
+    { 0,  1, -1}, { 0,  1,  0}, { 0,  1,  1},
+    { 0,  0,  1}
+};
+
+static int cellCoordinate(float position, float boxMin, float cellSize, int cells)
+{
+    // Bodies slightly past a wall are kept in the border cells.
+    int c = (int)((position - boxMin) / cellSize);
+    return std::min(std::max(c, 0), cells - 1);
+}
+
+void initSpatialGrid(SpatialGrid & grid, glm::vec3 boxMin, glm::vec3 boxMax, float cellSize)
+{
+    glm::vec3 extent = boxMax - boxMin;
+
+    grid.boxMin = boxMin;
+    grid.cellSize = cellSize;
+    grid.cellsX = std::max(1, (int)ceil(extent.x / cellSize));
+    grid.cellsY = std::max(1, (int)ceil(extent.y / cellSize));
+    grid.cellsZ = std::max(1, (int)ceil(extent.z / cellSize));
+    grid.cellStart.assign(grid.cellsX * grid.cellsY * grid.cellsZ + 1, 0);
+}
+
+void findCandidatePairs(
+    SpatialGrid & grid,
+    const float * posX,
+    const float * posY,
+    const float * posZ,
+    unsigned int count,
+    std::vector<BodyPair> & out_pairs
+){
+    unsigned int cellCount = grid.cellStart.size() - 1;
+
+    out_pairs.clear();
+    grid.bodyCell.resize(count);
+    grid.cellBodies.resize(count);
+    std::fill(grid.cellStart.begin(), grid.cellStart.end(), 0);
+
+    // Counting sort of the bodies by cell : count, prefix sum, then scatter.
+    for (unsigned int i = 0; i < count; i++)
+    {
+        int x = cellCoordinate(posX[i], grid.boxMin.x, grid.cellSize, grid.cellsX);
+        int y = cellCoordinate(posY[i], grid.boxMin.y, grid.cellSize, grid.cellsY);
+        int z = cellCoordinate(posZ[i], grid.boxMin.z, grid.cellSize, grid.cellsZ);
+        unsigned int cell = (z * grid.cellsY + y) * grid.cellsX + x;
+        grid.bodyCell[i] = cell;
+        grid.cellStart[cell + 1]++;
+    }
+
+    for (unsigned int c = 0; c < cellCount; c++)
+    {
+        grid.cellStart[c + 1] += grid.cellStart[c];
+    }
+
+    std::vector<unsigned int> cursor(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        grid.cellBodies[cursor[grid.bodyCell[i]]++] = i;
+    }
+
+    // Pairs inside a cell, then pairs between the cell and its forward neighbours.
+    for (int z = 0; z < grid.cellsZ; z++)
+    {
+        for (int y = 0; y < grid.cellsY; y++)
+        {
+            for (int x = 0; x < grid.cellsX; x++)
+            {
+                unsigned int cell = (z * grid.cellsY + y) * grid.cellsX + x;
+                unsigned int begin = grid.cellStart[cell];
+                unsigned int end = grid.cellStart[cell + 1];
+                if (begin == end)
+                {
+                    continue;
+                }
+
+                for (unsigned int i = begin; i < end; i++)
+                {
+                    for (unsigned int j = i + 1; j < end; j++)
+                    {
+                        BodyPair pair = {grid.cellBodies[i], grid.cellBodies[j]};
+                        out_pairs.push_back(pair);
+                    }
+                }
+
+                for (int n = 0; n < 13; n++)
+                {
+                    int nx = x + forwardNeighbours[n][0];
+                    int ny = y + forwardNeighbours[n][1];
+                    int nz = z + forwardNeighbours[n][2];
+                    if (nx < 0 || nx >= grid.cellsX || ny < 0 || ny >= grid.cellsY || nz < 0 || nz >= grid.cellsZ)
+                    {
+                        continue;
+                    }
+
+                    unsigned int neighbour = (nz * grid.cellsY + ny) * grid.cellsX + nx;
+                    for (unsigned int i = begin; i < end; i++)
+                    {
+                        for (unsigned int j = grid.cellStart[neighbour]; j < grid.cellStart[neighbour + 1]; j++)
+                        {
+                            unsigned int a = grid.cellBodies[i];
+                            unsigned int b = grid.cellBodies[j];
+                            BodyPair pair = {std::min(a, b), std::max(a, b)};
+                            out_pairs.push_back(pair);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void findCandidatePairs_slow(
+    const float * posX,
+    const float * posY,
+    const float * posZ,
+    unsigned int count,
+    float distance,
+    std::vector<BodyPair> & out_pairs
+){
+    out_pairs.clear();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        for (unsigned int j = i + 1; j < count; j++)
+        {
+            glm::vec3 d = glm::vec3(posX[i] - posX[j], posY[i] - posY[j], posZ[i] - posZ[j]);
+            if (glm::dot(d, d) < distance * distance)
+            {
+                BodyPair pair = {i, j};
+                out_pairs.push_back(pair);
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef BROADPHASE_HPP
+#define BROADPHASE_HPP
+
+// Two bodies whose cells are adjacent, a < b.
+struct BodyPair
+{
+    unsigned int a;
+    unsigned int b;
+};
+
+// Uniform cell grid covering the simulation box.
+// Bodies are counting-sorted by cell every step, so cellStart[c] .. cellStart[c+1]
+// is the range of cellBodies that lie in cell c.
+struct SpatialGrid
+{
+    glm::vec3 boxMin;
+    float cellSize;
+    int cellsX;
+    int cellsY;
+    int cellsZ;
+    std::vector<unsigned int> cellStart;
+    std::vector<unsigned int> cellBodies;
+    std::vector<unsigned int> bodyCell;
+};
+
+// cellSize should be at least the largest collision distance,
+// so that touching bodies are always in the same or in adjacent cells.
+void initSpatialGrid(SpatialGrid & grid, glm::vec3 boxMin, glm::vec3 boxMax, float cellSize);
+
+// Emits every pair of bodies that share a cell or lie in neighbouring cells.
+void findCandidatePairs(
+    SpatialGrid & grid,
+    const float * posX,
+    const float * posY,
+    const float * posZ,
+    unsigned int count,
+    std::vector<BodyPair> & out_pairs
+);
+
+// Reference brute-force version : tests all n*(n-1)/2 pairs.
+void findCandidatePairs_slow(
+    const float * posX,
+    const float * posY,
+    const float * posZ,
+    unsigned int count,
+    float distance,
+    std::vector<BodyPair> & out_pairs
+);
+
+#endif
@@ -0,0 +1,368 @@
+/*
+Description:
+
+This file is the continuous collision detection of the objects.
+Moving the objects by a whole step and then looking for overlaps misses the contacts
+of fast objects, which can jump over a wall or over each other in a single step.
+Here each object moves along a straight line during the step, the first moment it 
+touches a wall or another object is calculated, and the step is split at that moment.
+
+*/
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "broadphase.hpp"
+#include "bodystore.hpp"
+#include "ccd.hpp"
+
+// "other" of an impact with a wall : sweptWall + 2 * axis, + 1 for the wall on the positive side.
+#define sweptWall 0x80000000u
+
+void findSweptPairs(SpatialGrid & grid, const BodyStore & bodies, float distance, glm::vec3 wallMin, glm::vec3 wallMax,
+                    std::vector<BodyPair> & out_pairs)
+{
+    unsigned int count = bodies.count;
+    std::vector<float> middleX(count), middleY(count), middleZ(count);
+    float maxMove = 0.0f;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec3 velocity(bodies.velX[i], bodies.velY[i], bodies.velZ[i]);
+        maxMove = std::max(maxMove, glm::length(velocity));
+        middleX[i] = bodies.posX[i] + 0.5f * velocity.x;
+        middleY[i] = bodies.posY[i] + 0.5f * velocity.y;
+        middleZ[i] = bodies.posZ[i] + 0.5f * velocity.z;
+    }
+
+    // Two objects can only touch during the step if the middles of their moves are closer than
+    // distance + maxMove. The cells get twice that margin, for the objects which speed up in an impact.
+    // The grid is laid out again over the walls for this step's size, so it shrinks back when the objects slow down.
+    float cellSize = distance + 2.0f * maxMove;
+    if (cellSize != grid.cellSize)
+    {
+        initSpatialGrid(grid, wallMin, wallMax, cellSize);
+    }
+
+    if (count == 0)
+    {
+        out_pairs.clear();
+        return;
+    }
+    findCandidatePairs(grid, &middleX[0], &middleY[0], &middleZ[0], count, out_pairs);
+}
+
+// An object hitting another object or a wall at "time" (0 at the start of the step, 1 at the end).
+// The stamps tell whether the velocities changed since the impact was calculated, in which case it is dropped.
+struct Impact
+{
+    float time;
+    unsigned int body;
+    unsigned int other;
+    unsigned int bodyStamp;
+    unsigned int otherStamp;
+
+    bool operator>(const Impact & other) const
+    {
+        if (time != other.time)
+        {
+            return time > other.time;
+        }
+        return body != other.body ? body > other.body : this->other > other.other;
+    }
+};
+
+// During the step, the position of object i at time t is base[i] + velocity[i] * t.
+// When the velocity changes, base is moved so that the position at that moment stays the same.
+struct Sweep
+{
+    BodyStore * bodies;
+    float distance;
+    float restitution;
+    glm::vec3 wallMin;
+    glm::vec3 wallMax;
+    std::vector<glm::vec3> base;
+    std::vector<unsigned int> stamps;
+    std::vector<unsigned int> impactCounts;         // impacts of each object during the step
+    std::vector<unsigned int> neighbourStart;       // the pairs of object i are neighbours[neighbourStart[i] .. neighbourStart[i+1]]
+    std::vector<unsigned int> neighbours;
+    std::priority_queue<Impact, std::vector<Impact>, std::greater<Impact> > queue;
+};
+
+static glm::vec3 getVelocity(const Sweep & s, unsigned int i)
+{
+    return glm::vec3(s.bodies->velX[i], s.bodies->velY[i], s.bodies->velZ[i]);
+}
+
+static glm::vec3 getPositionAt(const Sweep & s, unsigned int i, float time)
+{
+    return s.base[i] + getVelocity(s, i) * time;
+}
+
+// Called after the velocity of i changed at "time", when i was at "position".
+static void setVelocity(Sweep & s, unsigned int i, glm::vec3 velocity, glm::vec3 position, float time)
+{
+    s.bodies->velX[i] = velocity.x;
+    s.bodies->velY[i] = velocity.y;
+    s.bodies->velZ[i] = velocity.z;
+    s.base[i] = position - velocity * time;
+    s.stamps[i]++;
+}
+
+// First moment in [now, 1] when a and b, moving towards each other, are at distance s.distance, or -1.
+static float getPairImpact(const Sweep & s, unsigned int a, unsigned int b, float now)
+{
+    if (s.bodies->invMass[a] + s.bodies->invMass[b] == 0.0f)
+    {
+        return -1.0f;
+    }
+
+    // |delta + relative * t| = distance is a quadratic equation in t.
+    glm::vec3 delta = s.base[b] - s.base[a];
+    glm::vec3 relative = getVelocity(s, b) - getVelocity(s, a);
+    float qa = glm::dot(relative, relative);
+    float qb = 2.0f * glm::dot(delta, relative);
+    float qc = glm::dot(delta, delta) - s.distance * s.distance;
+    if (qa < 1e-12f)
+    {
+        return -1.0f;
+    }
+    float discriminant = qb * qb - 4.0f * qa * qc;
+    if (discriminant <= 0.0f)
+    {
+        return -1.0f;
+    }
+
+    // They are closer than distance between the two roots.
+    float root = std::sqrt(discriminant);
+    float enter = (-qb - root) / (2.0f * qa);
+    float leave = (-qb + root) / (2.0f * qa);
+    if (enter >= now)
+    {
+        return enter <= 1.0f ? enter : -1.0f;
+    }
+
+    // Already touching at "now" : an impact right away if they are still getting closer.
+    glm::vec3 nowDelta = delta + relative * now;
+    return (now < leave && glm::dot(nowDelta, relative) < 0.0f) ? now : -1.0f;
+}
+
+static void queueImpact(Sweep & s, float time, unsigned int body, unsigned int other)
+{
+    Impact impact = {time, body, other, s.stamps[body], other & sweptWall ? 0u : s.stamps[other]};
+    s.queue.push(impact);
+}
+
+// Calculates the next impacts of object i with the walls and with its neighbours, from "now" on.
+static void queueImpacts(Sweep & s, unsigned int i, float now)
+{
+    if (s.bodies->invMass[i] == 0.0f || s.impactCounts[i] >= maxImpactsPerBody)
+    {
+        return;
+    }
+
+    glm::vec3 velocity = getVelocity(s, i);
+    glm::vec3 position = getPositionAt(s, i, now);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float v = velocity[axis];
+        if (v > 0.0f)
+        {
+            float time = position[axis] >= s.wallMax[axis] ? now : now + (s.wallMax[axis] - position[axis]) / v;
+            if (time <= 1.0f)
+            {
+                queueImpact(s, time, i, sweptWall + 2 * axis + 1);
+            }
+        }
+        else if (v < 0.0f)
+        {
+            float time = position[axis] <= s.wallMin[axis] ? now : now + (s.wallMin[axis] - position[axis]) / v;
+            if (time <= 1.0f)
+            {
+                queueImpact(s, time, i, sweptWall + 2 * axis);
+            }
+        }
+    }
+
+    for (unsigned int n = s.neighbourStart[i]; n < s.neighbourStart[i + 1]; n++)
+    {
+        unsigned int j = s.neighbours[n];
+        if (s.impactCounts[j] >= maxImpactsPerBody)
+        {
+            continue;
+        }
+        float time = getPairImpact(s, i, j, now);
+        if (time >= 0.0f)
+        {
+            queueImpact(s, time, i, j);
+        }
+    }
+}
+
+static void resolveWallImpact(Sweep & s, const Impact & impact)
+{
+    unsigned int i = impact.body;
+    int axis = (impact.other - sweptWall) / 2;
+    bool positiveSide = (impact.other - sweptWall) & 1;
+    static const int contactBits[3] = {wallContactX, wallContactY, wallContactZ};
+
+    glm::vec3 position = getPositionAt(s, i, impact.time);
+    glm::vec3 velocity = getVelocity(s, i);
+    position[axis] = positiveSide ? s.wallMax[axis] : s.wallMin[axis];
+    velocity[axis] = positiveSide ? -std::fabs(velocity[axis]) * s.restitution : std::fabs(velocity[axis]) * s.restitution;
+    s.bodies->wallContact[i] |= contactBits[axis];
+    setVelocity(s, i, velocity, position, impact.time);
+}
+
+// Same impulse as resolveSphereContacts(), at the moment the objects touch.
+static void resolvePairImpact(Sweep & s, const Impact & impact)
+{
+    unsigned int a = impact.body;
+    unsigned int b = impact.other;
+    float invMassA = s.bodies->invMass[a];
+    float invMassB = s.bodies->invMass[b];
+
+    glm::vec3 positionA = getPositionAt(s, a, impact.time);
+    glm::vec3 positionB = getPositionAt(s, b, impact.time);
+    glm::vec3 delta = positionB - positionA;
+    float length = glm::length(delta);
+    glm::vec3 normal = length > 1e-6f ? delta * (1.0f / length) : glm::vec3(0.0f, 0.0f, 1.0f);
+
+    glm::vec3 velocityA = getVelocity(s, a);
+    glm::vec3 velocityB = getVelocity(s, b);
+    float approach = glm::dot(velocityB - velocityA, normal);
+    if (approach >= 0.0f)
+    {
+        return;
+    }
+
+    float impulse = -(1.0f + s.restitution) * approach / (invMassA + invMassB);
+    setVelocity(s, a, velocityA - normal * (impulse * invMassA), positionA, impact.time);
+    setVelocity(s, b, velocityB + normal * (impulse * invMassB), positionB, impact.time);
+}
+
+unsigned int sweepBodies(BodyStore & bodies, const std::vector<unsigned int> & awake, const std::vector<BodyPair> & pairs,
+                         float distance, float restitution, glm::vec3 wallMin, glm::vec3 wallMax)
+{
+    unsigned int count = bodies.count;
+
+    Sweep s;
+    s.bodies = &bodies;
+    s.distance = distance;
+    s.restitution = restitution;
+    s.wallMin = wallMin;
+    s.wallMax = wallMax;
+    s.base.resize(count);
+    s.stamps.assign(count, 0);
+    s.impactCounts.assign(count, 0);
+
+    // The objects of the step : the awake ones, and the sleeping ones of the pairs, which the others can hit.
+    // The rest don't move and are not looked at.
+    std::vector<unsigned int> swept(awake);
+    std::vector<bool> listed(count, false);
+    for (unsigned int a = 0; a < awake.size(); a++)
+    {
+        listed[awake[a]] = true;
+    }
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        unsigned int ends[2] = {pairs[p].a, pairs[p].b};
+        for (int e = 0; e < 2; e++)
+        {
+            if (!listed[ends[e]])
+            {
+                listed[ends[e]] = true;
+                swept.push_back(ends[e]);
+            }
+        }
+    }
+    for (unsigned int w = 0; w < swept.size(); w++)
+    {
+        unsigned int i = swept[w];
+        s.base[i] = glm::vec3(bodies.posX[i], bodies.posY[i], bodies.posZ[i]);
+        bodies.wallContact[i] = 0;
+    }
+
+    // The pairs of each object, in both directions.
+    s.neighbourStart.assign(count + 1, 0);
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        s.neighbourStart[pairs[p].a + 1]++;
+        s.neighbourStart[pairs[p].b + 1]++;
+    }
+    for (unsigned int i = 0; i < count; i++)
+    {
+        s.neighbourStart[i + 1] += s.neighbourStart[i];
+    }
+    s.neighbours.resize(2 * pairs.size());
+    std::vector<unsigned int> cursor(s.neighbourStart.begin(), s.neighbourStart.end() - 1);
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        s.neighbours[cursor[pairs[p].a]++] = pairs[p].b;
+        s.neighbours[cursor[pairs[p].b]++] = pairs[p].a;
+    }
+
+    // A sleeping object doesn't move, the objects moving towards it find the impact.
+    // One which was hit by the narrow phase has a velocity and is swept like the others.
+    for (unsigned int w = 0; w < swept.size(); w++)
+    {
+        unsigned int i = swept[w];
+        if (!bodies.asleep[i] || bodies.velX[i] != 0.0f || bodies.velY[i] != 0.0f || bodies.velZ[i] != 0.0f)
+        {
+            queueImpacts(s, i, 0.0f);
+        }
+    }
+
+    // Handle the impacts in the order they happen. Each one changes the velocities of the objects
+    // it involves, so their next impacts are calculated again.
+    unsigned int impacts = 0;
+    while (!s.queue.empty())
+    {
+        Impact impact = s.queue.top();
+        s.queue.pop();
+
+        bool wall = (impact.other & sweptWall) != 0;
+        if (s.stamps[impact.body] != impact.bodyStamp || (!wall && s.stamps[impact.other] != impact.otherStamp))
+        {
+            continue;
+        }
+        // The impacts queued before an object reached its limit.
+        if (s.impactCounts[impact.body] >= maxImpactsPerBody || (!wall && s.impactCounts[impact.other] >= maxImpactsPerBody))
+        {
+            continue;
+        }
+
+        impacts++;
+        s.impactCounts[impact.body]++;
+        if (wall)
+        {
+            resolveWallImpact(s, impact);
+            queueImpacts(s, impact.body, impact.time);
+        }
+        else
+        {
+            s.impactCounts[impact.other]++;
+            resolvePairImpact(s, impact);
+            queueImpacts(s, impact.body, impact.time);
+            queueImpacts(s, impact.other, impact.time);
+        }
+    }
+
+    // Finish the step with the final velocities. The clamp only removes rounding errors,
+    // or the rest of the step of the objects which reached maxImpactsPerBody.
+    for (unsigned int w = 0; w < swept.size(); w++)
+    {
+        unsigned int i = swept[w];
+        glm::vec3 position = glm::clamp(getPositionAt(s, i, 1.0f), wallMin, wallMax);
+        bodies.posX[i] = position.x;
+        bodies.posY[i] = position.y;
+        bodies.posZ[i] = position.z;
+    }
+
+    return impacts;
+}
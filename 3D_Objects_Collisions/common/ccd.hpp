@@ -0,0 +1,26 @@
+#ifndef CCD_HPP
+#define CCD_HPP
+
+// Limit of impacts per object and step of sweepBodies().
+#define maxImpactsPerBody 16
+
+// Finds the pairs of objects which may touch at any moment of the next step, not only at its start.
+// The grid is searched with the middle of each object's move. It is laid out over the walls again whenever
+// the fastest object changes the size its cells need, distance when nothing moves.
+void findSweptPairs(SpatialGrid & grid, const BodyStore & bodies, float distance, glm::vec3 wallMin, glm::vec3 wallMax,
+                    std::vector<BodyPair> & out_pairs);
+
+// Moves every object by one step of its velocity, without letting it pass through the walls or through
+// another object on the way. The objects are spheres of diameter distance, and the walls are planes the
+// centers bounce on. The moments of impact are handled in the order they happen during the step :
+// the objects are moved to that moment, the velocities change like in resolveSphereContacts() and
+// clampBodiesToWalls(), and the rest of the step goes on with them.
+// An object squeezed between others can hit them over and over : past maxImpactsPerBody impacts in the step,
+// its impacts are no longer checked and it finishes the step with the velocity it has, while the others still are.
+// pairs must come from findSweptPairs(). Only the objects listed in awake and the objects of the pairs are moved,
+// the others must have no velocity, like the sleeping objects of sleep.hpp. The walls touched during the step
+// are written to wallContact of the moved objects. Returns the number of impacts.
+unsigned int sweepBodies(BodyStore & bodies, const std::vector<unsigned int> & awake, const std::vector<BodyPair> & pairs,
+                         float distance, float restitution, glm::vec3 wallMin, glm::vec3 wallMax);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+Description:
+
+This file skips the objects the camera can't see before anything is sent to OpenGL.
+Every object is bounded by a sphere centered on its position, and the spheres which
+are completely behind one of the six planes of the view frustum are left out of the draw.
+
+*/
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+#include "simd.hpp"
+#include "frustum.hpp"
+
+void extractFrustumPlanes(const glm::mat4 & viewProjection, Frustum & frustum)
+{
+    // Row r of the matrix is (m[0][r], m[1][r], m[2][r], m[3][r]) since glm stores the columns.
+    const glm::mat4 & m = viewProjection;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    // Left, right, bottom, top, near, far.
+    glm::vec4 planes[6] =
+    {
+        row3 + row0, row3 - row0,
+        row3 + row1, row3 - row1,
+        row3 + row2, row3 - row2
+    };
+
+    // Normalized, so that the value of a plane at a point is its distance to the point.
+    for (int k = 0; k < 6; k++)
+    {
+        float length = std::sqrt(planes[k].x * planes[k].x + planes[k].y * planes[k].y + planes[k].z * planes[k].z);
+        frustum.planeX[k] = planes[k].x / length;
+        frustum.planeY[k] = planes[k].y / length;
+        frustum.planeZ[k] = planes[k].z / length;
+        frustum.planeW[k] = planes[k].w / length;
+    }
+}
+
+float computeBoundingRadius(const void * vertexData, unsigned int vertexStride, unsigned int vertexCount)
+{
+    const char * vertex = (const char *)vertexData;
+    float maxSquared = 0.0f;
+    for (unsigned int i = 0; i < vertexCount; i++, vertex += vertexStride)
+    {
+        float position[3];
+        memcpy(position, vertex, sizeof(position));
+        float squared = position[0] * position[0] + position[1] * position[1] + position[2] * position[2];
+        if (squared > maxSquared)
+        {
+            maxSquared = squared;
+        }
+    }
+    return std::sqrt(maxSquared);
+}
+
+unsigned int cullSpheres(const Frustum & frustum, const float * posX, const float * posY, const float * posZ,
+                         unsigned int count, float radius, unsigned int * out_visible)
+{
+    float4 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int k = 0; k < 6; k++)
+    {
+        planeX[k] = float4Splat(frustum.planeX[k]);
+        planeY[k] = float4Splat(frustum.planeY[k]);
+        planeZ[k] = float4Splat(frustum.planeZ[k]);
+        // Adding the radius to the plane's offset tests the center against the plane pushed out by the radius.
+        planeW[k] = float4Splat(frustum.planeW[k] + radius);
+    }
+
+    unsigned int visible = 0;
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        float4 x = float4Load(posX + i);
+        float4 y = float4Load(posY + i);
+        float4 z = float4Load(posZ + i);
+
+        // The smallest signed distance over the six planes : negative if the sphere is outside one of them.
+        float4 nearest = float4MulAdd(x, planeX[0], float4MulAdd(y, planeY[0], float4MulAdd(z, planeZ[0], planeW[0])));
+        for (int k = 1; k < 6; k++)
+        {
+            float4 distance = float4MulAdd(x, planeX[k], float4MulAdd(y, planeY[k], float4MulAdd(z, planeZ[k], planeW[k])));
+            nearest = float4Min(nearest, distance);
+        }
+        int inside = ~float4NegativeMask(nearest) & 0xF;
+
+        // The lanes past the last sphere hold padding.
+        if (count - i < 4)
+        {
+            inside &= (1 << (count - i)) - 1;
+        }
+
+        // Append the visible lanes without branching : every lane is written, only the visible ones are kept.
+        for (unsigned int l = 0; l < 4; l++)
+        {
+            out_visible[visible] = i + l;
+            visible += (inside >> l) & 1;
+        }
+    }
+    return visible;
+}
+
+unsigned int cullSpheres_slow(const Frustum & frustum, const float * posX, const float * posY, const float * posZ,
+                              unsigned int count, float radius, unsigned int * out_visible)
+{
+    unsigned int visible = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        bool inside = true;
+        for (int k = 0; k < 6 && inside; k++)
+        {
+            float distance = frustum.planeX[k] * posX[i] + frustum.planeY[k] * posY[i] + frustum.planeZ[k] * posZ[i] + frustum.planeW[k];
+            inside = distance >= -radius;
+        }
+        if (inside)
+        {
+            out_visible[visible++] = i;
+        }
+    }
+    return visible;
+}
@@ -0,0 +1,34 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+// The six planes of the view frustum, normals pointing inside, each stored as one array per component
+// so that a plane is tested against four spheres at once. A point p is inside plane k when
+// planeX[k]*p.x + planeY[k]*p.y + planeZ[k]*p.z + planeW[k] >= 0.
+struct Frustum
+{
+    float planeX[6];
+    float planeY[6];
+    float planeZ[6];
+    float planeW[6];
+};
+
+// Extracts the planes from ProjectionMatrix * ViewMatrix (Gribb and Hartmann), in world space.
+void extractFrustumPlanes(const glm::mat4 & viewProjection, Frustum & frustum);
+
+// Radius of the sphere around the model's origin which contains every vertex. The origin is
+// what the model matrix rotates about, so the sphere holds the mesh whatever the rotation.
+// The position must be the first member of the vertices, as in InterleavedVertex and QuantizedVertex.
+float computeBoundingRadius(const void * vertexData, unsigned int vertexStride, unsigned int vertexCount);
+
+// Writes the index of every sphere that is at least partly inside the frustum to out_visible,
+// in increasing order, and returns how many there are. The spheres are tested four at a time,
+// so posX/posY/posZ must be readable up to count rounded up to 4, as the arrays of a BodyStore are.
+// out_visible must have room for count rounded up to 4 indices as well.
+unsigned int cullSpheres(const Frustum & frustum, const float * posX, const float * posY, const float * posZ,
+                         unsigned int count, float radius, unsigned int * out_visible);
+
+// Reference version : one sphere and one plane at a time.
+unsigned int cullSpheres_slow(const Frustum & frustum, const float * posX, const float * posY, const float * posZ,
+                              unsigned int count, float radius, unsigned int * out_visible);
+
+#endif
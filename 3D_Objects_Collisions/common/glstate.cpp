@@ -0,0 +1,294 @@
+/*
+Description:
+
+This file skips the OpenGL calls which would not change anything. Drawing the objects one by one
+binds the same buffers, points the attributes at the same places and sends the same uniforms for
+every object, and each of those calls costs time in the driver even when nothing changes.
+The cache keeps what was last sent, only sends the changes, and counts the calls it skipped.
+
+*/
+
+#include <vector>
+#include <cstring>
+
+#include <GL/glew.h>
+
+#include "glstate.hpp"
+
+static void forgetAttribute(CachedAttribute & attribute)
+{
+    attribute.enabled = unknownGLState;
+    attribute.divisor = unknownGLState;
+    attribute.buffer = unknownGLState;
+    attribute.type = unknownGLState;
+}
+
+void initGLStateCache(GLStateCache & state)
+{
+    resetGLStateCache(state);
+    state.frame.issued = 0;
+    state.frame.elided = 0;
+    state.lastFrame = state.frame;
+}
+
+void resetGLStateCache(GLStateCache & state)
+{
+    state.program = unknownGLState;
+    state.programSlot = -1;
+    state.arrayBuffer = unknownGLState;
+    state.elementArrayBuffer = unknownGLState;
+    state.activeTexture = unknownGLState;
+    for (int u = 0; u < maxCachedTextureUnits; u++)
+    {
+        state.textures[u] = unknownGLState;
+    }
+    for (int a = 0; a < maxCachedAttributes; a++)
+    {
+        forgetAttribute(state.attributes[a]);
+    }
+    state.programs.clear();
+}
+
+void beginGLStateFrame(GLStateCache & state)
+{
+    state.lastFrame = state.frame;
+    state.frame.issued = 0;
+    state.frame.elided = 0;
+}
+
+// Counts the call, and returns true if it has to be sent.
+static bool changes(GLStateCache & state, bool changed)
+{
+    if (changed)
+    {
+        state.frame.issued++;
+    }
+    else
+    {
+        state.frame.elided++;
+    }
+    return changed;
+}
+
+void cachedUseProgram(GLStateCache & state, GLuint program)
+{
+    if (!changes(state, state.program != program))
+    {
+        return;
+    }
+    glUseProgram(program);
+    state.program = program;
+
+    // The values of its uniforms stay with the program, find them again or start them unknown.
+    state.programSlot = -1;
+    for (unsigned int p = 0; p < state.programs.size(); p++)
+    {
+        if (state.programs[p].program == program)
+        {
+            state.programSlot = p;
+            break;
+        }
+    }
+    if (state.programSlot < 0)
+    {
+        ProgramUniforms uniforms;
+        uniforms.program = program;
+        for (int u = 0; u < maxCachedUniforms; u++)
+        {
+            uniforms.uniforms[u].type = 0;
+        }
+        state.programs.push_back(uniforms);
+        state.programSlot = state.programs.size() - 1;
+    }
+}
+
+void cachedBindBuffer(GLStateCache & state, GLenum target, GLuint buffer)
+{
+    GLuint * bound = NULL;
+    if (target == GL_ARRAY_BUFFER)
+    {
+        bound = &state.arrayBuffer;
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        bound = &state.elementArrayBuffer;
+    }
+
+    if (changes(state, bound == NULL || *bound != buffer))
+    {
+        glBindBuffer(target, buffer);
+        if (bound != NULL)
+        {
+            *bound = buffer;
+        }
+    }
+}
+
+void cachedActiveTexture(GLStateCache & state, GLenum unit)
+{
+    if (changes(state, state.activeTexture != unit))
+    {
+        glActiveTexture(unit);
+        state.activeTexture = unit;
+    }
+}
+
+void cachedBindTexture2D(GLStateCache & state, GLuint texture)
+{
+    GLuint unit = state.activeTexture - GL_TEXTURE0;
+    bool known = state.activeTexture != unknownGLState && unit < maxCachedTextureUnits;
+    if (changes(state, !known || state.textures[unit] != texture))
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (known)
+        {
+            state.textures[unit] = texture;
+        }
+    }
+}
+
+static void setAttributeEnabled(GLStateCache & state, GLuint index, GLuint enabled)
+{
+    bool known = index < maxCachedAttributes;
+    if (!changes(state, !known || state.attributes[index].enabled != enabled))
+    {
+        return;
+    }
+    if (enabled)
+    {
+        glEnableVertexAttribArray(index);
+    }
+    else
+    {
+        glDisableVertexAttribArray(index);
+    }
+    if (known)
+    {
+        state.attributes[index].enabled = enabled;
+    }
+}
+
+void cachedEnableVertexAttribArray(GLStateCache & state, GLuint index)
+{
+    setAttributeEnabled(state, index, 1);
+}
+
+void cachedDisableVertexAttribArray(GLStateCache & state, GLuint index)
+{
+    setAttributeEnabled(state, index, 0);
+}
+
+void cachedVertexAttribPointer(GLStateCache & state, GLuint index, GLint size, GLenum type, GLboolean normalized,
+                               GLsizei stride, const void * pointer)
+{
+    // Without knowing the bound buffer, the same pointer may read from another one.
+    bool known = index < maxCachedAttributes && state.arrayBuffer != unknownGLState;
+    if (known)
+    {
+        const CachedAttribute & attribute = state.attributes[index];
+        bool same = attribute.buffer == state.arrayBuffer && attribute.size == size && attribute.type == type &&
+                    attribute.normalized == normalized && attribute.stride == stride && attribute.pointer == pointer;
+        if (!changes(state, !same))
+        {
+            return;
+        }
+    }
+    else
+    {
+        changes(state, true);
+    }
+
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+    if (known)
+    {
+        CachedAttribute & attribute = state.attributes[index];
+        attribute.buffer = state.arrayBuffer;
+        attribute.size = size;
+        attribute.type = type;
+        attribute.normalized = normalized;
+        attribute.stride = stride;
+        attribute.pointer = pointer;
+    }
+}
+
+void cachedVertexAttribDivisor(GLStateCache & state, GLuint index, GLuint divisor)
+{
+    bool known = index < maxCachedAttributes;
+    if (changes(state, !known || state.attributes[index].divisor != divisor))
+    {
+        glVertexAttribDivisorARB(index, divisor);
+        if (known)
+        {
+            state.attributes[index].divisor = divisor;
+        }
+    }
+}
+
+// The cached value of a uniform of the current program, NULL if it can't be cached.
+static CachedUniform * findUniform(GLStateCache & state, GLint location)
+{
+    if (state.programSlot < 0 || location < 0 || location >= maxCachedUniforms)
+    {
+        return NULL;
+    }
+    return &state.programs[state.programSlot].uniforms[location];
+}
+
+// Counts the call, and returns true if the uniform doesn't hold the values yet, which it then does in the cache.
+// The values are compared bit for bit, so -0 and NaN are sent like any other change.
+static bool changesUniform(GLStateCache & state, GLint location, GLenum type, GLint intValue,
+                           const GLfloat * floatValues, int floatCount)
+{
+    CachedUniform * uniform = findUniform(state, location);
+    if (uniform == NULL)
+    {
+        return changes(state, true);
+    }
+
+    bool same = uniform->type == type && uniform->intValue == intValue &&
+                (floatCount == 0 || std::memcmp(uniform->floatValues, floatValues, floatCount * sizeof(GLfloat)) == 0);
+    if (changes(state, !same))
+    {
+        uniform->type = type;
+        uniform->intValue = intValue;
+        if (floatCount > 0)
+        {
+            std::memcpy(uniform->floatValues, floatValues, floatCount * sizeof(GLfloat));
+        }
+        return true;
+    }
+    return false;
+}
+
+void cachedUniform1i(GLStateCache & state, GLint location, GLint value)
+{
+    if (changesUniform(state, location, GL_INT, value, NULL, 0))
+    {
+        glUniform1i(location, value);
+    }
+}
+
+void cachedUniform1f(GLStateCache & state, GLint location, GLfloat value)
+{
+    if (changesUniform(state, location, GL_FLOAT, 0, &value, 1))
+    {
+        glUniform1f(location, value);
+    }
+}
+
+void cachedUniform3f(GLStateCache & state, GLint location, GLfloat x, GLfloat y, GLfloat z)
+{
+    GLfloat values[3] = {x, y, z};
+    if (changesUniform(state, location, GL_FLOAT_VEC3, 0, values, 3))
+    {
+        glUniform3f(location, x, y, z);
+    }
+}
+
+void cachedUniformMatrix4fv(GLStateCache & state, GLint location, const GLfloat * value)
+{
+    if (changesUniform(state, location, GL_FLOAT_MAT4, 0, value, 16))
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    }
+}
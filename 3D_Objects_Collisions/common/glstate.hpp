@@ -0,0 +1,97 @@
+#ifndef GLSTATE_HPP
+#define GLSTATE_HPP
+
+// What the cache remembers. Calls past these limits are always sent to the driver.
+#define maxCachedAttributes   16
+#define maxCachedTextureUnits 8
+#define maxCachedUniforms     32    // uniform locations per program
+
+// A state the cache doesn't know : the first call setting it is always sent.
+#define unknownGLState 0xFFFFFFFFu
+
+// Calls that went through the cache : sent to the driver, or skipped because they would not have changed anything.
+struct GLCallCounters
+{
+    unsigned int issued;
+    unsigned int elided;
+};
+
+// The pointer, the buffer it reads from and the enabled flag of a vertex attribute.
+struct CachedAttribute
+{
+    GLuint enabled;         // 0, 1 or unknownGLState
+    GLuint divisor;
+    GLuint buffer;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei stride;
+    const void * pointer;
+};
+
+// The last value sent to a uniform. type is 0 until one is sent.
+struct CachedUniform
+{
+    GLenum type;
+    GLint intValue;
+    GLfloat floatValues[16];
+};
+
+// Uniforms belong to the program, so every program has its own values.
+struct ProgramUniforms
+{
+    GLuint program;
+    CachedUniform uniforms[maxCachedUniforms];
+};
+
+// The GL state set by the render loop, as last sent to the driver. The cached* calls below only reach the driver
+// when they change something. All the calls to the state below must go through the cache, or it must be reset.
+struct GLStateCache
+{
+    GLuint program;
+    int programSlot;        // index of program in programs, -1 if unknown
+    GLuint arrayBuffer;
+    GLuint elementArrayBuffer;
+    GLenum activeTexture;
+    GLuint textures[maxCachedTextureUnits];     // GL_TEXTURE_2D of every unit
+    CachedAttribute attributes[maxCachedAttributes];
+    std::vector<ProgramUniforms> programs;
+
+    GLCallCounters frame;       // this frame so far
+    GLCallCounters lastFrame;   // the whole previous frame
+};
+
+// Starts with every state unknown.
+void initGLStateCache(GLStateCache & state);
+
+// Forgets every state, for when something changed them without going through the cache.
+void resetGLStateCache(GLStateCache & state);
+
+// Moves the counters of this frame to lastFrame and starts counting again.
+void beginGLStateFrame(GLStateCache & state);
+
+void cachedUseProgram(GLStateCache & state, GLuint program);
+
+// GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER are cached, the other targets are always bound.
+void cachedBindBuffer(GLStateCache & state, GLenum target, GLuint buffer);
+
+void cachedActiveTexture(GLStateCache & state, GLenum unit);
+void cachedBindTexture2D(GLStateCache & state, GLuint texture);
+
+void cachedEnableVertexAttribArray(GLStateCache & state, GLuint index);
+void cachedDisableVertexAttribArray(GLStateCache & state, GLuint index);
+
+// The attribute reads from the buffer bound to GL_ARRAY_BUFFER, so the same pointer into another buffer is sent again.
+void cachedVertexAttribPointer(GLStateCache & state, GLuint index, GLint size, GLenum type, GLboolean normalized,
+                               GLsizei stride, const void * pointer);
+
+// glVertexAttribDivisorARB, from ARB_instanced_arrays.
+void cachedVertexAttribDivisor(GLStateCache & state, GLuint index, GLuint divisor);
+
+// The uniforms of the current program. A location of -1 (a uniform the shader doesn't use) is sent as the GL expects.
+void cachedUniform1i(GLStateCache & state, GLint location, GLint value);
+void cachedUniform1f(GLStateCache & state, GLint location, GLfloat value);
+void cachedUniform3f(GLStateCache & state, GLint location, GLfloat x, GLfloat y, GLfloat z);
+void cachedUniformMatrix4fv(GLStateCache & state, GLint location, const GLfloat * value);
+
+#endif
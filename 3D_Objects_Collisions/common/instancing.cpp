@@ -0,0 +1,230 @@
+/*
+Description:
+
+This file draws all objects with one instanced call instead of one call per object.
+The model matrix and the internal light of every object are stored in one buffer 
+which the vertex shader reads once per instance.
+The matrices are built four objects at a time from the arrays of the BodyStore, together with
+their product with the view-projection matrix, and written straight into the mapped buffer.
+
+*/
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "glstate.hpp"
+#include "taskpool.hpp"
+#include "bodystore.hpp"
+#include "simd.hpp"
+#include "instancing.hpp"
+
+bool isInstancingSupported()
+{
+    return GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced;
+}
+
+void getInstanceAttributes(GLuint programID, InstanceAttributes & attributes)
+{
+    attributes.mvp[0] = glGetAttribLocation(programID, "instanceMVP0");
+    attributes.mvp[1] = glGetAttribLocation(programID, "instanceMVP1");
+    attributes.mvp[2] = glGetAttribLocation(programID, "instanceMVP2");
+    attributes.mvp[3] = glGetAttribLocation(programID, "instanceMVP3");
+    attributes.model[0] = glGetAttribLocation(programID, "instanceModel0");
+    attributes.model[1] = glGetAttribLocation(programID, "instanceModel1");
+    attributes.model[2] = glGetAttribLocation(programID, "instanceModel2");
+    attributes.model[3] = glGetAttribLocation(programID, "instanceModel3");
+    attributes.light = glGetAttribLocation(programID, "instanceLight");
+}
+
+// Builds the instances of order[begin .. end). The four lanes of the registers are four objects,
+// and every matrix is 16 registers, [column][row], until it is transposed to one register per column and object.
+static void buildInstanceRange(const BodyStore & bodies, const unsigned int * order, unsigned int begin, unsigned int end,
+                               const glm::mat4 & viewProjection, float lightPower, InstanceData * out_instances)
+{
+    float4 vp[4][4];
+    for (int c = 0; c < 4; c++)
+    {
+        for (int r = 0; r < 4; r++)
+        {
+            vp[c][r] = float4Splat(viewProjection[c][r]);
+        }
+    }
+    float4 zero = float4Splat(0.0f);
+    float4 one = float4Splat(1.0f);
+    float4 two = float4Splat(2.0f);
+    float4 power = float4Splat(lightPower);
+
+    for (unsigned int i = begin; i < end; i += 4)
+    {
+        // Gather the four objects. Past the end of the range, the last object is repeated.
+        float gathered[7][4];
+        for (unsigned int l = 0; l < 4; l++)
+        {
+            unsigned int b = order[std::min(i + l, end - 1)];
+            gathered[0][l] = bodies.posX[b];
+            gathered[1][l] = bodies.posY[b];
+            gathered[2][l] = bodies.posZ[b];
+            gathered[3][l] = bodies.rotW[b];
+            gathered[4][l] = bodies.rotX[b];
+            gathered[5][l] = bodies.rotY[b];
+            gathered[6][l] = bodies.rotZ[b];
+        }
+        float4 px = float4Load(gathered[0]);
+        float4 py = float4Load(gathered[1]);
+        float4 pz = float4Load(gathered[2]);
+        float4 qw = float4Load(gathered[3]);
+        float4 qx = float4Load(gathered[4]);
+        float4 qy = float4Load(gathered[5]);
+        float4 qz = float4Load(gathered[6]);
+
+        // The rotation of the quaternion, with the same operations as glm::mat3_cast(), and the position.
+        float4 x2 = float4Mul(qx, two);
+        float4 y2 = float4Mul(qy, two);
+        float4 z2 = float4Mul(qz, two);
+        float4 xx = float4Mul(qx, x2);
+        float4 yy = float4Mul(qy, y2);
+        float4 zz = float4Mul(qz, z2);
+        float4 xy = float4Mul(qx, y2);
+        float4 xz = float4Mul(qx, z2);
+        float4 yz = float4Mul(qy, z2);
+        float4 wx = float4Mul(qw, x2);
+        float4 wy = float4Mul(qw, y2);
+        float4 wz = float4Mul(qw, z2);
+
+        float4 model[4][4] =
+        {
+            {float4Sub(one, float4Add(yy, zz)), float4Add(xy, wz), float4Sub(xz, wy), zero},
+            {float4Sub(xy, wz), float4Sub(one, float4Add(xx, zz)), float4Add(yz, wx), zero},
+            {float4Add(xz, wy), float4Sub(yz, wx), float4Sub(one, float4Add(xx, yy)), zero},
+            {px, py, pz, one}
+        };
+
+        // viewProjection * model, summed in the order glm sums it. The last row of the model matrix is (0, 0, 0, 1),
+        // so the last column of viewProjection is only added to the last column.
+        float4 mvp[4][4];
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                float4 sum = float4MulAdd(vp[2][r], model[c][2], float4MulAdd(vp[1][r], model[c][1], float4Mul(vp[0][r], model[c][0])));
+                mvp[c][r] = c == 3 ? float4Add(sum, vp[3][r]) : sum;
+            }
+        }
+
+        float4 light[4] = {px, py, pz, power};
+        for (int c = 0; c < 4; c++)
+        {
+            float4Transpose(mvp[c][0], mvp[c][1], mvp[c][2], mvp[c][3]);
+            float4Transpose(model[c][0], model[c][1], model[c][2], model[c][3]);
+        }
+        float4Transpose(light[0], light[1], light[2], light[3]);
+
+        // One instance after the other, so a mapped buffer is written in order.
+        unsigned int groupCount = std::min(end - i, 4u);
+        for (unsigned int l = 0; l < groupCount; l++)
+        {
+            InstanceData & instance = out_instances[i + l];
+            for (int c = 0; c < 4; c++)
+            {
+                float4Store(&instance.mvp[c][0], mvp[c][l]);
+            }
+            for (int c = 0; c < 4; c++)
+            {
+                float4Store(&instance.model[c][0], model[c][l]);
+            }
+            float4Store(&instance.light[0], light[l]);
+        }
+    }
+}
+
+void buildInstances(TaskPool & pool, const BodyStore & bodies, const unsigned int * order, unsigned int count,
+                    const glm::mat4 & viewProjection, float lightPower, InstanceData * out_instances)
+{
+    parallelFor(pool, count, instanceGrain, [&](unsigned int begin, unsigned int end)
+    {
+        buildInstanceRange(bodies, order, begin, end, viewProjection, lightPower, out_instances);
+    });
+}
+
+void buildInstances_slow(const BodyStore & bodies, const unsigned int * order, unsigned int count,
+                         const glm::mat4 & viewProjection, float lightPower, InstanceData * out_instances)
+{
+    for (unsigned int s = 0; s < count; s++)
+    {
+        unsigned int i = order[s];
+        out_instances[s].model = getBodyModelMatrix(bodies, i);
+        out_instances[s].mvp = viewProjection * out_instances[s].model;
+        out_instances[s].light = glm::vec4(getBodyPosition(bodies, i), lightPower);
+    }
+}
+
+InstanceData * mapInstances(GLStateCache & state, GLuint instancebuffer, unsigned int count)
+{
+    cachedBindBuffer(state, GL_ARRAY_BUFFER, instancebuffer);
+    // Orphan the old storage first, so mapping does not wait for the previous frame's draw.
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+    return (InstanceData *)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+}
+
+bool unmapInstances(GLStateCache & state, GLuint instancebuffer)
+{
+    cachedBindBuffer(state, GL_ARRAY_BUFFER, instancebuffer);
+    return glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+}
+
+void uploadInstances(GLStateCache & state, GLuint instancebuffer, const std::vector<InstanceData> & instances)
+{
+    cachedBindBuffer(state, GL_ARRAY_BUFFER, instancebuffer);
+    // Orphan the old storage first, so the driver does not wait for the previous frame's draw.
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(InstanceData), &instances[0]);
+}
+
+void bindInstanceAttributes(GLStateCache & state, GLuint instancebuffer, const InstanceAttributes & attributes, unsigned int firstInstance)
+{
+    cachedBindBuffer(state, GL_ARRAY_BUFFER, instancebuffer);
+    size_t offset = firstInstance * sizeof(InstanceData);
+
+    for (int c = 0; c < 4; c++)
+    {
+        cachedEnableVertexAttribArray(state, attributes.mvp[c]);
+        cachedVertexAttribPointer(state, attributes.mvp[c], 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + c * sizeof(glm::vec4)));
+        cachedVertexAttribDivisor(state, attributes.mvp[c], 1);
+    }
+
+    for (int c = 0; c < 4; c++)
+    {
+        cachedEnableVertexAttribArray(state, attributes.model[c]);
+        cachedVertexAttribPointer(state, attributes.model[c], 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + sizeof(glm::mat4) + c * sizeof(glm::vec4)));
+        cachedVertexAttribDivisor(state, attributes.model[c], 1);
+    }
+
+    cachedEnableVertexAttribArray(state, attributes.light);
+    cachedVertexAttribPointer(state, attributes.light, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + 2 * sizeof(glm::mat4)));
+    cachedVertexAttribDivisor(state, attributes.light, 1);
+}
+
+void unbindInstanceAttributes(GLStateCache & state, const InstanceAttributes & attributes)
+{
+    for (int c = 0; c < 4; c++)
+    {
+        cachedVertexAttribDivisor(state, attributes.mvp[c], 0);
+        cachedDisableVertexAttribArray(state, attributes.mvp[c]);
+        cachedVertexAttribDivisor(state, attributes.model[c], 0);
+        cachedDisableVertexAttribArray(state, attributes.model[c]);
+    }
+    cachedVertexAttribDivisor(state, attributes.light, 0);
+    cachedDisableVertexAttribArray(state, attributes.light);
+}
@@ -0,0 +1,59 @@
+#ifndef INSTANCING_HPP
+#define INSTANCING_HPP
+
+// Instances built by one range of buildInstances(). A multiple of 4, so only the last range has a partial group.
+#define instanceGrain 1024
+
+// What the instanced vertex shader reads for each object.
+struct InstanceData
+{
+    glm::mat4 mvp;      // viewProjection * model, so the shader does not multiply them for every vertex
+    glm::mat4 model;
+    glm::vec4 light;    // xyz : position of the internal light, w : its power
+};
+
+// Locations of the per-instance attributes in the instanced shader.
+struct InstanceAttributes
+{
+    GLuint mvp[4];      // one vec4 attribute per column of the matrices
+    GLuint model[4];
+    GLuint light;
+};
+
+// True if the context can draw instances (ARB_instanced_arrays and ARB_draw_instanced).
+// The GL 2.1 context of the tutorials does not always have them.
+bool isInstancingSupported();
+
+void getInstanceAttributes(GLuint programID, InstanceAttributes & attributes);
+
+// Writes the instance of the objects order[0] .. order[count - 1] to out_instances[0] .. out_instances[count - 1] :
+// the model matrix of the object, viewProjection times it, and its internal light at lightPower.
+// The matrices of four objects are built at once from the arrays of the BodyStore, and the ranges
+// of instanceGrain objects are shared by the threads of the pool. Writes every instance once and in order,
+// so out_instances can be a mapped buffer.
+void buildInstances(TaskPool & pool, const BodyStore & bodies, const unsigned int * order, unsigned int count,
+                    const glm::mat4 & viewProjection, float lightPower, InstanceData * out_instances);
+
+// Reference version : one object at a time, with getBodyModelMatrix().
+void buildInstances_slow(const BodyStore & bodies, const unsigned int * order, unsigned int count,
+                         const glm::mat4 & viewProjection, float lightPower, InstanceData * out_instances);
+
+// Replaces the storage of the buffer by room for count instances and maps it for writing,
+// so the instances are built straight into it. Returns NULL if the buffer can't be mapped.
+InstanceData * mapInstances(GLStateCache & state, GLuint instancebuffer, unsigned int count);
+
+// Unmaps the buffer again. Returns false if its contents were lost while it was mapped, which the GL allows
+// (a mode change for example) : the instances have to be uploaded again.
+bool unmapInstances(GLStateCache & state, GLuint instancebuffer);
+
+// Sends the data of all instances to the buffer, replacing the previous frame's data.
+void uploadInstances(GLStateCache & state, GLuint instancebuffer, const std::vector<InstanceData> & instances);
+
+// Points the per-instance attributes at the buffer, starting at firstInstance, and makes them advance once per instance.
+// ARB_draw_instanced has no base instance, so drawing a range of the instances goes through this offset.
+void bindInstanceAttributes(GLStateCache & state, GLuint instancebuffer, const InstanceAttributes & attributes, unsigned int firstInstance);
+
+// Disables the per-instance attributes again, so the next non-instanced draw is not affected.
+void unbindInstanceAttributes(GLStateCache & state, const InstanceAttributes & attributes);
+
+#endif
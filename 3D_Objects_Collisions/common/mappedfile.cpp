@@ -0,0 +1,101 @@
+/*
+Description:
+
+This file gives read-only access to the whole content of a file without going through stdio.
+On POSIX systems the file is mapped with mmap, so the pages are only read from the disk
+when the parser touches them and nothing is copied. On Windows the file is read in one fread.
+
+*/
+
+#include <vector>
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mappedfile.hpp"
+
+bool openMappedFile(MappedFile & file, const char * path)
+{
+    file.data = NULL;
+    file.size = 0;
+    file.mapping = NULL;
+    file.copy.clear();
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    if (info.st_size > 0)
+    {
+        void * mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+        // The file is read from the beginning to the end.
+        madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+        file.mapping = mapping;
+        file.data = (const char *)mapping;
+        file.size = info.st_size;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+    return true;
+#else
+    FILE * f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size > 0)
+    {
+        file.copy.resize(size);
+        if (fread(&file.copy[0], 1, size, f) != (size_t)size)
+        {
+            fclose(f);
+            file.copy.clear();
+            return false;
+        }
+        file.data = &file.copy[0];
+        file.size = size;
+    }
+
+    fclose(f);
+    return true;
+#endif
+}
+
+void closeMappedFile(MappedFile & file)
+{
+#ifndef _WIN32
+    if (file.mapping != NULL)
+    {
+        munmap(file.mapping, file.size);
+    }
+#endif
+    file.data = NULL;
+    file.size = 0;
+    file.mapping = NULL;
+    file.copy.clear();
+}
@@ -0,0 +1,19 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+// Read-only view of a whole file.
+// On POSIX systems the file is mapped in memory, elsewhere it is read into "copy".
+struct MappedFile
+{
+    const char * data;
+    size_t size;
+    void * mapping;
+    std::vector<char> copy;
+};
+
+// Returns false if the file can't be opened. An empty file gives data = NULL and size = 0.
+bool openMappedFile(MappedFile & file, const char * path);
+
+void closeMappedFile(MappedFile & file);
+
+#endif
@@ -0,0 +1,795 @@
+/*
+Description:
+
+This file builds a bounding volume hierarchy (BVH) over the triangles of a mesh and answers
+ray, sphere and mesh-against-mesh queries with it. Each node bounds its triangles with a box,
+so a query only looks at the triangles of the boxes it reaches, instead of every triangle.
+
+*/
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "taskpool.hpp"
+#include "obb.hpp"
+#include "meshbvh.hpp"
+
+// Bins of the surface area heuristic along each axis.
+#define bvhBinCount              16
+// Cost of testing a box, for a cost of 1 per triangle tested.
+#define bvhTraversalCost         1.0f
+// Subtrees with fewer triangles than this are built by one thread.
+#define parallelSubtreeTriangles 4096
+
+// A triangle while the BVH is built.
+struct BuildTriangle
+{
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    glm::vec3 centroid;
+    unsigned int index;
+};
+
+// A subtree left for the threads : its triangles, and the node of the upper tree it replaces.
+struct BvhSubtree
+{
+    unsigned int first;
+    unsigned int count;
+    unsigned int node;
+    unsigned int depth;
+};
+
+static float getSurfaceArea(glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+    glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+static void getBounds(const BuildTriangle * triangles, unsigned int count, glm::vec3 & out_min, glm::vec3 & out_max)
+{
+    out_min = glm::vec3(FLT_MAX);
+    out_max = glm::vec3(-FLT_MAX);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        out_min = glm::min(out_min, triangles[i].boundsMin);
+        out_max = glm::max(out_max, triangles[i].boundsMax);
+    }
+}
+
+static BvhNode makeNode(glm::vec3 boundsMin, glm::vec3 boundsMax, unsigned int offset, unsigned int triangleCount)
+{
+    BvhNode node;
+    for (int k = 0; k < 3; k++)
+    {
+        node.boundsMin[k] = boundsMin[k];
+        node.boundsMax[k] = boundsMax[k];
+    }
+    node.offset = offset;
+    node.triangleCount = triangleCount;
+    return node;
+}
+
+// Splits triangles[0 .. count) in two where the surface area heuristic is the lowest, with the triangles
+// sorted in bins by centroid. Returns the number of triangles of the first side, or 0 for a leaf.
+static unsigned int splitTriangles(BuildTriangle * triangles, unsigned int count, float nodeArea)
+{
+    if (count <= 1)
+    {
+        return 0;
+    }
+
+    glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        centroidMin = glm::min(centroidMin, triangles[i].centroid);
+        centroidMax = glm::max(centroidMax, triangles[i].centroid);
+    }
+
+    float bestCost = FLT_MAX;
+    int bestAxis = -1;
+    int bestBin = 0;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f)
+        {
+            continue;
+        }
+
+        unsigned int binCounts[bvhBinCount] = {0};
+        glm::vec3 binMin[bvhBinCount], binMax[bvhBinCount];
+        for (int b = 0; b < bvhBinCount; b++)
+        {
+            binMin[b] = glm::vec3(FLT_MAX);
+            binMax[b] = glm::vec3(-FLT_MAX);
+        }
+        float scale = bvhBinCount / extent;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            int b = std::min((int)((triangles[i].centroid[axis] - centroidMin[axis]) * scale), bvhBinCount - 1);
+            binCounts[b]++;
+            binMin[b] = glm::min(binMin[b], triangles[i].boundsMin);
+            binMax[b] = glm::max(binMax[b], triangles[i].boundsMax);
+        }
+
+        // Areas and counts of everything right of each plane between two bins, then a sweep from the left.
+        float rightArea[bvhBinCount];
+        unsigned int rightCount[bvhBinCount];
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+        unsigned int sum = 0;
+        for (int b = bvhBinCount - 1; b > 0; b--)
+        {
+            boundsMin = glm::min(boundsMin, binMin[b]);
+            boundsMax = glm::max(boundsMax, binMax[b]);
+            sum += binCounts[b];
+            rightArea[b] = getSurfaceArea(boundsMin, boundsMax);
+            rightCount[b] = sum;
+        }
+        boundsMin = glm::vec3(FLT_MAX);
+        boundsMax = glm::vec3(-FLT_MAX);
+        sum = 0;
+        for (int b = 0; b < bvhBinCount - 1; b++)
+        {
+            boundsMin = glm::min(boundsMin, binMin[b]);
+            boundsMax = glm::max(boundsMax, binMax[b]);
+            sum += binCounts[b];
+            if (sum == 0 || rightCount[b + 1] == 0)
+            {
+                continue;
+            }
+            float cost = getSurfaceArea(boundsMin, boundsMax) * sum + rightArea[b + 1] * rightCount[b + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    // All centroids in one point : only a split in the middle of the list can make the leaves small enough.
+    if (bestAxis < 0)
+    {
+        return count > maxLeafTriangles ? count / 2 : 0;
+    }
+
+    // Keep a leaf when testing its triangles costs less than testing two boxes and then the triangles behind them.
+    float splitCost = bvhTraversalCost + bestCost / std::max(nodeArea, FLT_MIN);
+    if (splitCost >= (float)count && count <= maxLeafTriangles)
+    {
+        return 0;
+    }
+
+    float scale = bvhBinCount / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+    float low = centroidMin[bestAxis];
+    BuildTriangle * middle = std::partition(triangles, triangles + count, [&](const BuildTriangle & t)
+    {
+        return std::min((int)((t.centroid[bestAxis] - low) * scale), bvhBinCount - 1) <= bestBin;
+    });
+    return middle - triangles;
+}
+
+// Appends the subtree of triangles[first .. first + count) to out_nodes, depth first.
+// With subtrees, the nodes of fewer than parallelSubtreeTriangles triangles are not built but
+// left as empty leaves, and listed in subtrees.
+static void buildNode(BuildTriangle * triangles, unsigned int first, unsigned int count, unsigned int depth,
+                      std::vector<BvhNode> & out_nodes, std::vector<BvhSubtree> * subtrees)
+{
+    glm::vec3 boundsMin, boundsMax;
+    getBounds(triangles + first, count, boundsMin, boundsMax);
+    unsigned int node = out_nodes.size();
+    out_nodes.push_back(makeNode(boundsMin, boundsMax, first, count));
+
+    if (subtrees && count < parallelSubtreeTriangles)
+    {
+        BvhSubtree subtree = {first, count, node, depth};
+        subtrees->push_back(subtree);
+        return;
+    }
+
+    if (depth + 1 >= bvhStackSize)
+    {
+        return;
+    }
+    unsigned int leftCount = splitTriangles(triangles + first, count, getSurfaceArea(boundsMin, boundsMax));
+    if (leftCount == 0)
+    {
+        return;
+    }
+
+    out_nodes[node].triangleCount = 0;
+    buildNode(triangles, first, leftCount, depth + 1, out_nodes, subtrees);
+    out_nodes[node].offset = out_nodes.size();
+    buildNode(triangles, first + leftCount, count - leftCount, depth + 1, out_nodes, subtrees);
+}
+
+// Copies the upper tree from node on to out_nodes, putting each subtree in place of its empty leaf.
+static void mergeSubtrees(const std::vector<BvhNode> & upper, unsigned int node, const std::vector<int> & subtreeOfNode,
+                          const std::vector< std::vector<BvhNode> > & subtreeNodes, std::vector<BvhNode> & out_nodes)
+{
+    if (subtreeOfNode[node] >= 0)
+    {
+        const std::vector<BvhNode> & nodes = subtreeNodes[subtreeOfNode[node]];
+        unsigned int base = out_nodes.size();
+        for (unsigned int n = 0; n < nodes.size(); n++)
+        {
+            out_nodes.push_back(nodes[n]);
+            if (nodes[n].triangleCount == 0)
+            {
+                out_nodes.back().offset += base;
+            }
+        }
+        return;
+    }
+
+    unsigned int index = out_nodes.size();
+    out_nodes.push_back(upper[node]);
+    if (upper[node].triangleCount == 0)
+    {
+        mergeSubtrees(upper, node + 1, subtreeOfNode, subtreeNodes, out_nodes);
+        out_nodes[index].offset = out_nodes.size();
+        mergeSubtrees(upper, upper[node].offset, subtreeOfNode, subtreeNodes, out_nodes);
+    }
+}
+
+static glm::vec3 getVertexPosition(const char * vertex)
+{
+    float position[3];
+    memcpy(position, vertex, sizeof(position));
+    return glm::vec3(position[0], position[1], position[2]);
+}
+
+void buildMeshBvh(
+    TaskPool & pool,
+    const void * vertexData,
+    unsigned int vertexStride,
+    const unsigned int * indices,
+    unsigned int indexCount,
+    std::vector<BvhNode> & out_nodes,
+    std::vector<BvhTriangle> & out_triangles
+){
+    out_nodes.clear();
+    out_triangles.clear();
+    unsigned int triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    const char * vertices = (const char *)vertexData;
+    std::vector<BvhTriangle> meshTriangles(triangleCount);
+    std::vector<BuildTriangle> triangles(triangleCount);
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        BvhTriangle & triangle = meshTriangles[t];
+        for (int k = 0; k < 3; k++)
+        {
+            triangle.vertices[k] = getVertexPosition(vertices + (size_t)indices[3 * t + k] * vertexStride);
+        }
+        triangles[t].boundsMin = glm::min(glm::min(triangle.vertices[0], triangle.vertices[1]), triangle.vertices[2]);
+        triangles[t].boundsMax = glm::max(glm::max(triangle.vertices[0], triangle.vertices[1]), triangle.vertices[2]);
+        triangles[t].centroid = (triangle.vertices[0] + triangle.vertices[1] + triangle.vertices[2]) * (1.0f / 3.0f);
+        triangles[t].index = t;
+    }
+
+    // The upper levels are split by this thread, down to subtrees small enough for one thread each.
+    // The subtrees cover disjoint ranges of "triangles", so the threads sort them in place.
+    std::vector<BvhNode> upper;
+    std::vector<BvhSubtree> subtrees;
+    buildNode(&triangles[0], 0, triangleCount, 0, upper, &subtrees);
+
+    std::vector< std::vector<BvhNode> > subtreeNodes(subtrees.size());
+    parallelFor(pool, subtrees.size(), 1, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int s = begin; s < end; s++)
+        {
+            // Built on their own, the subtrees count their nodes from 0. mergeSubtrees() moves them.
+            buildNode(&triangles[0], subtrees[s].first, subtrees[s].count, subtrees[s].depth, subtreeNodes[s], NULL);
+        }
+    });
+
+    std::vector<int> subtreeOfNode(upper.size(), -1);
+    for (unsigned int s = 0; s < subtrees.size(); s++)
+    {
+        subtreeOfNode[subtrees[s].node] = s;
+    }
+    mergeSubtrees(upper, 0, subtreeOfNode, subtreeNodes, out_nodes);
+
+    out_triangles.resize(triangleCount);
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        out_triangles[t] = meshTriangles[triangles[t].index];
+    }
+}
+
+MeshBvh getMeshBvh(const std::vector<BvhNode> & nodes, const std::vector<BvhTriangle> & triangles)
+{
+    MeshBvh bvh;
+    bvh.nodes = nodes.empty() ? NULL : &nodes[0];
+    bvh.nodeCount = nodes.size();
+    bvh.triangles = triangles.empty() ? NULL : &triangles[0];
+    bvh.triangleCount = triangles.size();
+    return bvh;
+}
+
+// Möller-Trumbore. Returns the t of the hit, or -1.
+static float intersectRayTriangle(glm::vec3 origin, glm::vec3 direction, const BvhTriangle & triangle)
+{
+    glm::vec3 edge1 = triangle.vertices[1] - triangle.vertices[0];
+    glm::vec3 edge2 = triangle.vertices[2] - triangle.vertices[0];
+    glm::vec3 p = glm::cross(direction, edge2);
+    float determinant = glm::dot(edge1, p);
+    if (std::fabs(determinant) < 1e-12f)
+    {
+        return -1.0f;
+    }
+    float inverse = 1.0f / determinant;
+    glm::vec3 s = origin - triangle.vertices[0];
+    float u = glm::dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+    {
+        return -1.0f;
+    }
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+    {
+        return -1.0f;
+    }
+    return glm::dot(edge2, q) * inverse;
+}
+
+// Slab test. Returns the t where the ray enters the box, or FLT_MAX if it misses it before maxT.
+static float intersectRayNode(glm::vec3 origin, glm::vec3 inverseDirection, const BvhNode & node, float maxT)
+{
+    float enter = 0.0f;
+    float leave = maxT;
+    for (int k = 0; k < 3; k++)
+    {
+        float t0 = (node.boundsMin[k] - origin[k]) * inverseDirection[k];
+        float t1 = (node.boundsMax[k] - origin[k]) * inverseDirection[k];
+        enter = std::max(enter, std::min(t0, t1));
+        leave = std::min(leave, std::max(t0, t1));
+    }
+    return enter <= leave ? enter : FLT_MAX;
+}
+
+bool raycastMeshBvh(const MeshBvh & bvh, const glm::mat3 & rotation, glm::vec3 translation,
+                    glm::vec3 origin, glm::vec3 direction, float & inout_t, unsigned int & out_triangle)
+{
+    if (bvh.nodeCount == 0)
+    {
+        return false;
+    }
+
+    // Move the ray in model space instead of moving the mesh. The rotation keeps the t of the hits.
+    glm::mat3 inverse = glm::transpose(rotation);
+    origin = inverse * (origin - translation);
+    direction = inverse * direction;
+    glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    bool hit = false;
+    unsigned int stack[bvhStackSize];
+    int stackSize = 0;
+    unsigned int node = 0;
+    if (intersectRayNode(origin, inverseDirection, bvh.nodes[0], inout_t) == FLT_MAX)
+    {
+        return false;
+    }
+    for (;;)
+    {
+        const BvhNode & current = bvh.nodes[node];
+        if (current.triangleCount > 0)
+        {
+            for (unsigned int t = current.offset; t < current.offset + current.triangleCount; t++)
+            {
+                float tHit = intersectRayTriangle(origin, direction, bvh.triangles[t]);
+                if (tHit >= 0.0f && tHit < inout_t)
+                {
+                    inout_t = tHit;
+                    out_triangle = t;
+                    hit = true;
+                }
+            }
+        }
+        else
+        {
+            // Visit the nearer child first, so the farther one is often behind the hit and skipped.
+            unsigned int first = node + 1;
+            unsigned int second = current.offset;
+            float tFirst = intersectRayNode(origin, inverseDirection, bvh.nodes[first], inout_t);
+            float tSecond = intersectRayNode(origin, inverseDirection, bvh.nodes[second], inout_t);
+            if (tSecond < tFirst)
+            {
+                std::swap(first, second);
+                std::swap(tFirst, tSecond);
+            }
+            if (tFirst != FLT_MAX)
+            {
+                if (tSecond != FLT_MAX)
+                {
+                    stack[stackSize++] = second;
+                }
+                node = first;
+                continue;
+            }
+        }
+
+        // Next node on the stack, unless the ray already hit something before it.
+        for (;;)
+        {
+            if (stackSize == 0)
+            {
+                return hit;
+            }
+            node = stack[--stackSize];
+            if (intersectRayNode(origin, inverseDirection, bvh.nodes[node], inout_t) != FLT_MAX)
+            {
+                break;
+            }
+        }
+    }
+}
+
+bool raycastMeshBvh_slow(const MeshBvh & bvh, const glm::mat3 & rotation, glm::vec3 translation,
+                         glm::vec3 origin, glm::vec3 direction, float & inout_t, unsigned int & out_triangle)
+{
+    glm::mat3 inverse = glm::transpose(rotation);
+    origin = inverse * (origin - translation);
+    direction = inverse * direction;
+
+    bool hit = false;
+    for (unsigned int t = 0; t < bvh.triangleCount; t++)
+    {
+        float tHit = intersectRayTriangle(origin, direction, bvh.triangles[t]);
+        if (tHit >= 0.0f && tHit < inout_t)
+        {
+            inout_t = tHit;
+            out_triangle = t;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+// Closest point of a triangle to p (Ericson, Real-Time Collision Detection, 5.1.5).
+static glm::vec3 closestPointOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    {
+        return a;
+    }
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+    {
+        return b;
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        return a + ab * (d1 / (d1 - d3));
+    }
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+    {
+        return c;
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        return a + ac * (d2 / (d2 - d6));
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+    {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+bool overlapMeshBvhSphere(const MeshBvh & bvh, const glm::mat3 & rotation, glm::vec3 translation,
+                          glm::vec3 center, float radius)
+{
+    if (bvh.nodeCount == 0)
+    {
+        return false;
+    }
+
+    center = glm::transpose(rotation) * (center - translation);
+    float squaredRadius = radius * radius;
+
+    unsigned int stack[bvhStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const BvhNode & node = bvh.nodes[stack[--stackSize]];
+        unsigned int index = &node - bvh.nodes;
+
+        // Distance from the center to the box.
+        glm::vec3 boundsMin(node.boundsMin[0], node.boundsMin[1], node.boundsMin[2]);
+        glm::vec3 boundsMax(node.boundsMax[0], node.boundsMax[1], node.boundsMax[2]);
+        glm::vec3 outside = center - glm::clamp(center, boundsMin, boundsMax);
+        if (glm::dot(outside, outside) > squaredRadius)
+        {
+            continue;
+        }
+
+        if (node.triangleCount > 0)
+        {
+            for (unsigned int t = node.offset; t < node.offset + node.triangleCount; t++)
+            {
+                const BvhTriangle & triangle = bvh.triangles[t];
+                glm::vec3 d = center - closestPointOnTriangle(center, triangle.vertices[0], triangle.vertices[1], triangle.vertices[2]);
+                if (glm::dot(d, d) <= squaredRadius)
+                {
+                    return true;
+                }
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.offset;
+            stack[stackSize++] = index + 1;
+        }
+    }
+    return false;
+}
+
+// The largest dot(direction, point) over the points of the box of a node.
+static float getNodeSupport(const BvhNode & node, glm::vec3 direction)
+{
+    float support = 0.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        support += std::max(direction[k] * node.boundsMin[k], direction[k] * node.boundsMax[k]);
+    }
+    return support;
+}
+
+float getMeshBvhSupport(const MeshBvh & bvh, glm::vec3 direction)
+{
+    float best = -FLT_MAX;
+    if (bvh.nodeCount == 0)
+    {
+        return best;
+    }
+
+    unsigned int stack[bvhStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        unsigned int index = stack[--stackSize];
+        const BvhNode & node = bvh.nodes[index];
+
+        // No vertex of the node goes further than its box.
+        if (getNodeSupport(node, direction) <= best)
+        {
+            continue;
+        }
+
+        if (node.triangleCount > 0)
+        {
+            for (unsigned int t = node.offset; t < node.offset + node.triangleCount; t++)
+            {
+                for (int v = 0; v < 3; v++)
+                {
+                    best = std::max(best, glm::dot(direction, bvh.triangles[t].vertices[v]));
+                }
+            }
+        }
+        else
+        {
+            // The child whose box goes further is visited first, so the other one is often skipped.
+            unsigned int first = index + 1;
+            unsigned int second = node.offset;
+            if (getNodeSupport(bvh.nodes[second], direction) > getNodeSupport(bvh.nodes[first], direction))
+            {
+                std::swap(first, second);
+            }
+            stack[stackSize++] = second;
+            stack[stackSize++] = first;
+        }
+    }
+    return best;
+}
+
+// Separating axis test of two triangles : their normals, the cross products of their edges, and for
+// triangles in one plane, the directions in the plane across each edge.
+static bool intersectTriangles(const glm::vec3 * a, const glm::vec3 * b)
+{
+    glm::vec3 edgesA[3] = {a[1] - a[0], a[2] - a[1], a[0] - a[2]};
+    glm::vec3 edgesB[3] = {b[1] - b[0], b[2] - b[1], b[0] - b[2]};
+    glm::vec3 normalA = glm::cross(edgesA[0], edgesA[1]);
+    glm::vec3 normalB = glm::cross(edgesB[0], edgesB[1]);
+
+    glm::vec3 axes[17];
+    int axisCount = 0;
+    axes[axisCount++] = normalA;
+    axes[axisCount++] = normalB;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            axes[axisCount++] = glm::cross(edgesA[i], edgesB[j]);
+        }
+        axes[axisCount++] = glm::cross(normalA, edgesA[i]);
+        axes[axisCount++] = glm::cross(normalB, edgesB[i]);
+    }
+
+    for (int k = 0; k < axisCount; k++)
+    {
+        glm::vec3 axis = axes[k];
+        if (glm::dot(axis, axis) < 1e-20f)
+        {
+            continue;
+        }
+        float minA = FLT_MAX, maxA = -FLT_MAX, minB = FLT_MAX, maxB = -FLT_MAX;
+        for (int v = 0; v < 3; v++)
+        {
+            float pa = glm::dot(a[v], axis);
+            float pb = glm::dot(b[v], axis);
+            minA = std::min(minA, pa);
+            maxA = std::max(maxA, pa);
+            minB = std::min(minB, pb);
+            maxB = std::max(maxB, pb);
+        }
+        if (maxA < minB || maxB < minA)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static OrientedBox getNodeBox(const BvhNode & node)
+{
+    OrientedBox box;
+    glm::vec3 boundsMin(node.boundsMin[0], node.boundsMin[1], node.boundsMin[2]);
+    glm::vec3 boundsMax(node.boundsMax[0], node.boundsMax[1], node.boundsMax[2]);
+    box.center = (boundsMin + boundsMax) * 0.5f;
+    box.halfExtents = (boundsMax - boundsMin) * 0.5f;
+    box.axes[0] = glm::vec3(1.0f, 0.0f, 0.0f);
+    box.axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+    box.axes[2] = glm::vec3(0.0f, 0.0f, 1.0f);
+    return box;
+}
+
+// Tests the triangles of two leaves. The triangles of b are moved in the model space of a.
+static bool intersectLeaves(const MeshBvh & a, const BvhNode & leafA, const MeshBvh & b, const BvhNode & leafB,
+                            const glm::mat3 & rotation, glm::vec3 translation)
+{
+    for (unsigned int tb = leafB.offset; tb < leafB.offset + leafB.triangleCount; tb++)
+    {
+        glm::vec3 triangleB[3];
+        for (int v = 0; v < 3; v++)
+        {
+            triangleB[v] = rotation * b.triangles[tb].vertices[v] + translation;
+        }
+        for (unsigned int ta = leafA.offset; ta < leafA.offset + leafA.triangleCount; ta++)
+        {
+            if (intersectTriangles(a.triangles[ta].vertices, triangleB))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool overlapMeshBvhs(const MeshBvh & a, const glm::mat3 & rotationA, glm::vec3 translationA,
+                     const MeshBvh & b, const glm::mat3 & rotationB, glm::vec3 translationB)
+{
+    if (a.nodeCount == 0 || b.nodeCount == 0)
+    {
+        return false;
+    }
+
+    // Everything happens in the model space of a : the boxes of a stay axis aligned, those of b are rotated.
+    glm::mat3 inverseA = glm::transpose(rotationA);
+    glm::mat3 rotation = inverseA * rotationB;
+    glm::vec3 translation = inverseA * (translationB - translationA);
+
+    // Pairs of nodes whose boxes may overlap. A pair makes at most two, so the stack is twice as deep.
+    unsigned int stack[2 * bvhStackSize][2];
+    int stackSize = 0;
+    stack[stackSize][0] = 0;
+    stack[stackSize][1] = 0;
+    stackSize++;
+    while (stackSize > 0)
+    {
+        stackSize--;
+        unsigned int nodeA = stack[stackSize][0];
+        unsigned int nodeB = stack[stackSize][1];
+        const BvhNode & na = a.nodes[nodeA];
+        const BvhNode & nb = b.nodes[nodeB];
+
+        glm::vec3 normal;
+        float depth;
+        OrientedBox boxB = transformOBB(getNodeBox(nb), rotation, translation);
+        if (!intersectOBB(getNodeBox(na), boxB, normal, depth))
+        {
+            continue;
+        }
+
+        bool leafA = na.triangleCount > 0;
+        bool leafB = nb.triangleCount > 0;
+        if (leafA && leafB)
+        {
+            if (intersectLeaves(a, na, b, nb, rotation, translation))
+            {
+                return true;
+            }
+            continue;
+        }
+
+        // Open the larger box, so both sides shrink at about the same pace.
+        float areaA = getSurfaceArea(glm::vec3(na.boundsMin[0], na.boundsMin[1], na.boundsMin[2]),
+                                     glm::vec3(na.boundsMax[0], na.boundsMax[1], na.boundsMax[2]));
+        float areaB = getSurfaceArea(glm::vec3(nb.boundsMin[0], nb.boundsMin[1], nb.boundsMin[2]),
+                                     glm::vec3(nb.boundsMax[0], nb.boundsMax[1], nb.boundsMax[2]));
+        if (leafB || (!leafA && areaA >= areaB))
+        {
+            stack[stackSize][0] = na.offset;
+            stack[stackSize][1] = nodeB;
+            stackSize++;
+            stack[stackSize][0] = nodeA + 1;
+            stack[stackSize][1] = nodeB;
+            stackSize++;
+        }
+        else
+        {
+            stack[stackSize][0] = nodeA;
+            stack[stackSize][1] = nb.offset;
+            stackSize++;
+            stack[stackSize][0] = nodeA;
+            stack[stackSize][1] = nodeB + 1;
+            stackSize++;
+        }
+    }
+    return false;
+}
+
+bool overlapMeshBvhs_slow(const MeshBvh & a, const glm::mat3 & rotationA, glm::vec3 translationA,
+                          const MeshBvh & b, const glm::mat3 & rotationB, glm::vec3 translationB)
+{
+    glm::mat3 inverseA = glm::transpose(rotationA);
+    glm::mat3 rotation = inverseA * rotationB;
+    glm::vec3 translation = inverseA * (translationB - translationA);
+
+    for (unsigned int tb = 0; tb < b.triangleCount; tb++)
+    {
+        glm::vec3 triangleB[3];
+        for (int v = 0; v < 3; v++)
+        {
+            triangleB[v] = rotation * b.triangles[tb].vertices[v] + translation;
+        }
+        for (unsigned int ta = 0; ta < a.triangleCount; ta++)
+        {
+            if (intersectTriangles(a.triangles[ta].vertices, triangleB))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
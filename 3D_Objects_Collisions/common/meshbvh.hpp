@@ -0,0 +1,79 @@
+#ifndef MESHBVH_HPP
+#define MESHBVH_HPP
+
+// Most triangles in a leaf of the BVH.
+#define maxLeafTriangles 4
+// Nodes of the stacks of the queries. The root is at depth 0 and the nodes at depth bvhStackSize - 1 are leaves
+// whatever their number of triangles, so the stacks never hold more nodes than this. A deeper BVH can't be queried.
+#define bvhStackSize     64
+
+// One node of a BVH, 32 bytes so two of them fit in a cache line. The nodes are stored depth first :
+// the first child of an inner node is the node right after it, and offset is the index of the second child.
+// A leaf has triangleCount > 0 and holds the triangles offset .. offset + triangleCount - 1.
+struct BvhNode
+{
+    float boundsMin[3];
+    uint32_t offset;
+    float boundsMax[3];
+    uint32_t triangleCount;
+};
+
+// A triangle of a BVH, in model space. The triangles are stored in the order of the leaves,
+// so a leaf reads them from one place.
+struct BvhTriangle
+{
+    glm::vec3 vertices[3];
+};
+
+// A BVH over the triangles of a mesh. The arrays belong to whoever built or loaded them : the vectors
+// given to buildMeshBvh(), or the mapped file of a CachedMesh.
+struct MeshBvh
+{
+    const BvhNode * nodes;
+    unsigned int nodeCount;
+    const BvhTriangle * triangles;
+    unsigned int triangleCount;
+};
+
+// Builds the BVH of the triangles of "indices", whose positions are the first member of the vertices.
+// Every node is split where the surface area heuristic expects the fewest box and triangle tests,
+// and the subtrees of large meshes are built by the threads of the pool. The result does not depend
+// on the number of threads.
+void buildMeshBvh(
+    TaskPool & pool,
+    const void * vertexData,
+    unsigned int vertexStride,
+    const unsigned int * indices,
+    unsigned int indexCount,
+    std::vector<BvhNode> & out_nodes,
+    std::vector<BvhTriangle> & out_triangles
+);
+
+MeshBvh getMeshBvh(const std::vector<BvhNode> & nodes, const std::vector<BvhTriangle> & triangles);
+
+// The queries place the mesh like an object of the BodyStore : rotated by rotation, then moved by translation.
+
+// Finds the first triangle hit by the ray origin + t * direction, with 0 <= t < inout_t. If there is one,
+// returns true, and sets inout_t to the t of the hit and out_triangle to the index of the triangle.
+bool raycastMeshBvh(const MeshBvh & bvh, const glm::mat3 & rotation, glm::vec3 translation,
+                    glm::vec3 origin, glm::vec3 direction, float & inout_t, unsigned int & out_triangle);
+
+// True if a triangle of the mesh is closer than radius to center.
+bool overlapMeshBvhSphere(const MeshBvh & bvh, const glm::mat3 & rotation, glm::vec3 translation,
+                          glm::vec3 center, float radius);
+
+// How far the mesh reaches along direction, in model space : the largest dot(direction, vertex) over its vertices.
+// -FLT_MAX for an empty BVH.
+float getMeshBvhSupport(const MeshBvh & bvh, glm::vec3 direction);
+
+// True if a triangle of mesh a crosses or touches a triangle of mesh b.
+bool overlapMeshBvhs(const MeshBvh & a, const glm::mat3 & rotationA, glm::vec3 translationA,
+                     const MeshBvh & b, const glm::mat3 & rotationB, glm::vec3 translationB);
+
+// The same as raycastMeshBvh() and overlapMeshBvhs(), testing every triangle. Used to check them.
+bool raycastMeshBvh_slow(const MeshBvh & bvh, const glm::mat3 & rotation, glm::vec3 translation,
+                         glm::vec3 origin, glm::vec3 direction, float & inout_t, unsigned int & out_triangle);
+bool overlapMeshBvhs_slow(const MeshBvh & a, const glm::mat3 & rotationA, glm::vec3 translationA,
+                          const MeshBvh & b, const glm::mat3 & rotationB, glm::vec3 translationB);
+
+#endif
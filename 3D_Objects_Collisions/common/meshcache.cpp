@@ -0,0 +1,356 @@
+/*
+Description:
+
+This file stores an indexed mesh in a binary file next to its source, so the next launches
+can skip loadOBJ and indexVBO : the cache file is mapped in memory and its vertex and index
+data are given to glBufferData as they are, so loading the mesh costs a page-in.
+
+Layout of a cache file (little-endian, like every machine this runs on) :
+    MeshCacheHeader
+    path of the source, sourcePathLength bytes
+    padding to 16 bytes
+    vertexCount vertices of vertexStride bytes, in the layout given by vertexFormat
+    padding to 16 bytes
+    indexCount indices of indexSize bytes
+    padding to 16 bytes
+    lodCount MeshLod, ranges of the indices
+    padding to 16 bytes
+    bvhNodeCount BvhNode, the BVH of level 0
+    padding to 16 bytes
+    bvhTriangleCount BvhTriangle, in the order of the leaves
+
+*/
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <glm/glm.hpp>
+
+#include "mappedfile.hpp"
+#include "vboindexer.hpp"
+#include "meshlod.hpp"
+#include "taskpool.hpp"
+#include "meshbvh.hpp"
+#include "meshcache.hpp"
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t sourceHash;
+    uint32_t sourcePathLength;
+    uint32_t vertexFormat;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexSize;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    uint32_t reserved;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t lodOffset;
+    uint32_t bvhNodeCount;
+    uint32_t bvhTriangleCount;
+    uint64_t bvhNodeOffset;
+    uint64_t bvhTriangleOffset;
+};
+
+static const char meshCacheMagic[8] = {'O', 'G', 'L', 'M', 'E', 'S', 'H', 0};
+
+static uint64_t alignTo16(uint64_t offset)
+{
+    return (offset + 15) & ~(uint64_t)15;
+}
+
+// 64-bit FNV-1a of the content of a file.
+static bool hashFile(const char * path, unsigned long long & hash)
+{
+    MappedFile file;
+    if (!openMappedFile(file, path))
+    {
+        return false;
+    }
+
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < file.size; i++)
+    {
+        h ^= (unsigned char)file.data[i];
+        h *= 1099511628211ull;
+    }
+    hash = h;
+
+    closeMappedFile(file);
+    return true;
+}
+
+std::string getMeshCachePath(const char * sourcePath)
+{
+    return std::string(sourcePath) + ".meshcache";
+}
+
+bool loadMeshCache(CachedMesh & mesh, const char * sourcePath, MeshSourceKey & sourceKey)
+{
+    mesh.vertexData = NULL;
+    mesh.indexData = NULL;
+    mesh.vertexCount = 0;
+    mesh.indexCount = 0;
+    mesh.lods = NULL;
+    mesh.lodCount = 0;
+    mesh.bvh.nodes = NULL;
+    mesh.bvh.nodeCount = 0;
+    mesh.bvh.triangles = NULL;
+    mesh.bvh.triangleCount = 0;
+
+    struct stat info;
+    if (stat(sourcePath, &info) != 0)
+    {
+        return false;
+    }
+    sourceKey.size = info.st_size;
+    sourceKey.mtime = info.st_mtime;
+    sourceKey.hash = 0;
+
+    // Only hash the source when the size and the time can't tell whether the cache is valid.
+    bool hashed = false;
+    std::string cachePath = getMeshCachePath(sourcePath);
+    if (openMappedFile(mesh.file, cachePath.c_str()))
+    {
+        const MeshCacheHeader * header = (const MeshCacheHeader *)mesh.file.data;
+        size_t pathLength = strlen(sourcePath);
+        bool valid =
+            mesh.file.size >= sizeof(MeshCacheHeader) &&
+            memcmp(header->magic, meshCacheMagic, sizeof(meshCacheMagic)) == 0 &&
+            header->version == meshCacheVersion &&
+            header->headerSize == sizeof(MeshCacheHeader) &&
+            header->sourcePathLength == pathLength &&
+            mesh.file.size >= sizeof(MeshCacheHeader) + pathLength &&
+            memcmp(mesh.file.data + sizeof(MeshCacheHeader), sourcePath, pathLength) == 0 &&
+            (header->indexSize == 2 || header->indexSize == 4) &&
+            header->vertexOffset % 16 == 0 &&
+            header->indexOffset % 16 == 0 &&
+            header->vertexOffset + (uint64_t)header->vertexStride * header->vertexCount <= mesh.file.size &&
+            header->indexOffset + (uint64_t)header->indexSize * header->indexCount <= mesh.file.size &&
+            header->lodCount > 0 && header->lodCount <= maxLodCount &&
+            header->lodOffset % 16 == 0 &&
+            header->lodOffset + (uint64_t)sizeof(MeshLod) * header->lodCount <= mesh.file.size &&
+            header->bvhNodeOffset % 16 == 0 &&
+            header->bvhNodeOffset + (uint64_t)sizeof(BvhNode) * header->bvhNodeCount <= mesh.file.size &&
+            header->bvhTriangleOffset % 16 == 0 &&
+            header->bvhTriangleOffset + (uint64_t)sizeof(BvhTriangle) * header->bvhTriangleCount <= mesh.file.size &&
+            header->sourceSize == sourceKey.size;
+
+        if (valid && header->sourceMtime != sourceKey.mtime)
+        {
+            // The file was touched (a checkout, a copy...) : the cache is still good if the content is the same.
+            hashed = hashFile(sourcePath, sourceKey.hash);
+            valid = hashed && header->sourceHash == sourceKey.hash;
+        }
+
+        if (valid)
+        {
+            sourceKey.hash = header->sourceHash;
+            mesh.vertexFormat = header->vertexFormat;
+            mesh.vertexStride = header->vertexStride;
+            mesh.vertexCount = header->vertexCount;
+            mesh.vertexData = mesh.file.data + header->vertexOffset;
+            mesh.indexSize = header->indexSize;
+            mesh.indexCount = header->indexCount;
+            mesh.indexData = mesh.file.data + header->indexOffset;
+            mesh.lodCount = header->lodCount;
+            mesh.lods = (const MeshLod *)(mesh.file.data + header->lodOffset);
+            for (unsigned int l = 0; l < mesh.lodCount; l++)
+            {
+                valid = valid && (uint64_t)mesh.lods[l].firstIndex + mesh.lods[l].indexCount <= mesh.indexCount;
+            }
+
+            // An index past the vertices would make the GL read outside the vertex buffer.
+            uint32_t maxIndex = 0;
+            if (mesh.indexSize == 2)
+            {
+                const uint16_t * indices = (const uint16_t *)mesh.indexData;
+                for (unsigned int i = 0; i < mesh.indexCount; i++)
+                {
+                    maxIndex = std::max<uint32_t>(maxIndex, indices[i]);
+                }
+            }
+            else
+            {
+                const uint32_t * indices = (const uint32_t *)mesh.indexData;
+                for (unsigned int i = 0; i < mesh.indexCount; i++)
+                {
+                    maxIndex = std::max(maxIndex, indices[i]);
+                }
+            }
+            valid = valid && (mesh.indexCount == 0 || maxIndex < mesh.vertexCount);
+
+            // A child is always after its parent, so walking the nodes can't loop, and the depth of a node
+            // is known before its children are reached. The queries can't go deeper than their stacks.
+            mesh.bvh.nodeCount = header->bvhNodeCount;
+            mesh.bvh.nodes = (const BvhNode *)(mesh.file.data + header->bvhNodeOffset);
+            mesh.bvh.triangleCount = header->bvhTriangleCount;
+            mesh.bvh.triangles = (const BvhTriangle *)(mesh.file.data + header->bvhTriangleOffset);
+            std::vector<unsigned int> nodeDepth(valid ? mesh.bvh.nodeCount : 0, 0);
+            for (unsigned int n = 0; valid && n < mesh.bvh.nodeCount; n++)
+            {
+                const BvhNode & node = mesh.bvh.nodes[n];
+                if (node.triangleCount > 0)
+                {
+                    valid = (uint64_t)node.offset + node.triangleCount <= mesh.bvh.triangleCount;
+                }
+                else
+                {
+                    valid = node.offset > n + 1 && node.offset < mesh.bvh.nodeCount && nodeDepth[n] + 1 < bvhStackSize;
+                    if (valid)
+                    {
+                        nodeDepth[n + 1] = std::max(nodeDepth[n + 1], nodeDepth[n] + 1);
+                        nodeDepth[node.offset] = std::max(nodeDepth[node.offset], nodeDepth[n] + 1);
+                    }
+                }
+            }
+        }
+
+        if (valid)
+        {
+            return true;
+        }
+        closeMeshCache(mesh);
+    }
+
+    if (!hashed)
+    {
+        hashFile(sourcePath, sourceKey.hash);
+    }
+    return false;
+}
+
+void closeMeshCache(CachedMesh & mesh)
+{
+    closeMappedFile(mesh.file);
+    mesh.vertexData = NULL;
+    mesh.indexData = NULL;
+    mesh.vertexCount = 0;
+    mesh.indexCount = 0;
+    mesh.lods = NULL;
+    mesh.lodCount = 0;
+    mesh.bvh.nodes = NULL;
+    mesh.bvh.nodeCount = 0;
+    mesh.bvh.triangles = NULL;
+    mesh.bvh.triangleCount = 0;
+}
+
+bool saveMeshCache(
+    const char * sourcePath,
+    const MeshSourceKey & sourceKey,
+    unsigned int vertexFormat,
+    unsigned int vertexStride,
+    unsigned int vertexCount,
+    const void * vertexData,
+    const std::vector<unsigned int> & indices,
+    const std::vector<MeshLod> & lods,
+    const std::vector<BvhNode> & bvhNodes,
+    const std::vector<BvhTriangle> & bvhTriangles
+){
+    uint32_t pathLength = strlen(sourcePath);
+
+    // 16-bit indices if every index fits.
+    uint32_t indexSize = 2;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (indices[i] > std::numeric_limits<unsigned short>::max())
+        {
+            indexSize = 4;
+            break;
+        }
+    }
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, meshCacheMagic, sizeof(meshCacheMagic));
+    header.version = meshCacheVersion;
+    header.headerSize = sizeof(MeshCacheHeader);
+    header.sourceSize = sourceKey.size;
+    header.sourceMtime = sourceKey.mtime;
+    header.sourceHash = sourceKey.hash;
+    header.sourcePathLength = pathLength;
+    header.vertexFormat = vertexFormat;
+    header.vertexStride = vertexStride;
+    header.vertexCount = vertexCount;
+    header.indexSize = indexSize;
+    header.indexCount = indices.size();
+    header.vertexOffset = alignTo16(sizeof(MeshCacheHeader) + pathLength);
+    header.indexOffset = alignTo16(header.vertexOffset + (uint64_t)vertexStride * vertexCount);
+    header.lodCount = lods.size();
+    header.lodOffset = alignTo16(header.indexOffset + (uint64_t)indexSize * indices.size());
+    header.bvhNodeCount = bvhNodes.size();
+    header.bvhNodeOffset = alignTo16(header.lodOffset + sizeof(MeshLod) * lods.size());
+    header.bvhTriangleCount = bvhTriangles.size();
+    header.bvhTriangleOffset = alignTo16(header.bvhNodeOffset + sizeof(BvhNode) * bvhNodes.size());
+
+    std::vector<char> data(header.bvhTriangleOffset + sizeof(BvhTriangle) * bvhTriangles.size(), 0);
+    memcpy(&data[0], &header, sizeof(header));
+    memcpy(&data[sizeof(header)], sourcePath, pathLength);
+    if (vertexCount > 0)
+    {
+        memcpy(&data[header.vertexOffset], vertexData, (size_t)vertexStride * vertexCount);
+    }
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (indexSize == 2)
+        {
+            unsigned short index = indices[i];
+            memcpy(&data[header.indexOffset + 2 * i], &index, 2);
+        }
+        else
+        {
+            memcpy(&data[header.indexOffset + 4 * i], &indices[i], 4);
+        }
+    }
+
+    if (!lods.empty())
+    {
+        memcpy(&data[header.lodOffset], &lods[0], sizeof(MeshLod) * lods.size());
+    }
+    if (!bvhNodes.empty())
+    {
+        memcpy(&data[header.bvhNodeOffset], &bvhNodes[0], sizeof(BvhNode) * bvhNodes.size());
+    }
+    if (!bvhTriangles.empty())
+    {
+        memcpy(&data[header.bvhTriangleOffset], &bvhTriangles[0], sizeof(BvhTriangle) * bvhTriangles.size());
+    }
+
+    // Written next to the cache then renamed, so a crash never leaves half a cache behind.
+    std::string cachePath = getMeshCachePath(sourcePath);
+    std::string temporaryPath = cachePath + ".tmp";
+    FILE * file = fopen(temporaryPath.c_str(), "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    bool written = fwrite(&data[0], 1, data.size(), file) == data.size();
+    written = fclose(file) == 0 && written;
+    if (!written)
+    {
+        remove(temporaryPath.c_str());
+        return false;
+    }
+    remove(cachePath.c_str());
+    return rename(temporaryPath.c_str(), cachePath.c_str()) == 0;
+}
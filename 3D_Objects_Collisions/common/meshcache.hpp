@@ -0,0 +1,61 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+// Bump when the layout of the cache file changes : older caches are then rebuilt.
+#define meshCacheVersion 3
+
+// Layouts of the vertex data of a cache.
+#define meshVertexFloat     0 // InterleavedVertex
+#define meshVertexQuantized 1 // QuantizedVertex
+
+// What a cache was built from. A cache is valid if the source still has the same size
+// and modification time, or, if only the time changed, the same content hash.
+struct MeshSourceKey
+{
+    unsigned long long size;
+    long long mtime;
+    unsigned long long hash;
+};
+
+// An indexed mesh read from a cache file. The pointers point in the mapped file,
+// so they stay valid until closeMeshCache().
+struct CachedMesh
+{
+    MappedFile file;
+    unsigned int vertexFormat;
+    unsigned int vertexStride;
+    unsigned int vertexCount;
+    const void * vertexData;
+    unsigned int indexSize;
+    unsigned int indexCount;
+    const void * indexData;
+    unsigned int lodCount;
+    const MeshLod * lods;
+    MeshBvh bvh;
+};
+
+// The cache of "suzanne.obj" is "suzanne.obj.meshcache", next to it.
+std::string getMeshCachePath(const char * sourcePath);
+
+// Opens the cache of sourcePath. Returns false if there is none, or if it is out of date.
+// sourceKey is filled in both cases (if the source exists), to be given to saveMeshCache().
+bool loadMeshCache(CachedMesh & mesh, const char * sourcePath, MeshSourceKey & sourceKey);
+
+void closeMeshCache(CachedMesh & mesh);
+
+// Writes the cache of sourcePath. Indices are stored on 16 bits when they all fit.
+// The levels of detail are ranges of "indices". The BVH is stored as it is, see buildMeshBvh().
+bool saveMeshCache(
+    const char * sourcePath,
+    const MeshSourceKey & sourceKey,
+    unsigned int vertexFormat,
+    unsigned int vertexStride,
+    unsigned int vertexCount,
+    const void * vertexData,
+    const std::vector<unsigned int> & indices,
+    const std::vector<MeshLod> & lods,
+    const std::vector<BvhNode> & bvhNodes,
+    const std::vector<BvhTriangle> & bvhTriangles
+);
+
+#endif
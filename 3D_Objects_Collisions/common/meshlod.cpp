@@ -0,0 +1,445 @@
+/*
+Description:
+
+This file builds levels of detail of a mesh and picks one for each object every frame.
+The simplifier collapses one edge at a time, always the one whose collapse moves the surface the least,
+measured with quadric error metrics : every vertex carries the sum of the squared distances
+to the planes of its triangles, so the error of moving it anywhere is one quadratic form.
+Far objects are then drawn with a level that has far fewer triangles but looks the same on screen.
+
+*/
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "vboindexer.hpp"
+#include "vertexcache.hpp"
+#include "meshlod.hpp"
+
+// Edges with a triangle on one side only get a plane perpendicular to that triangle,
+// weighted so that the open borders (like the eyes of suzanne) keep their shape.
+#define borderPlaneWeight 10.0
+
+// Each level keeps this fraction of the triangles of the previous one.
+#define lodTriangleRatio  (1.0f / 3.0f)
+
+// Symmetric 4x4 matrix of a quadric : error(p) = p^T Q p with p = (x, y, z, 1).
+// "weight" is the sum of the weights of its planes, to turn an error back into a distance.
+struct Quadric
+{
+    double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+    double weight;
+};
+
+static void addPlane(Quadric & q, glm::vec3 normal, float d, double weight)
+{
+    double a = normal.x, b = normal.y, c = normal.z, w = d;
+    q.xx += weight * a * a; q.xy += weight * a * b; q.xz += weight * a * c; q.xw += weight * a * w;
+    q.yy += weight * b * b; q.yz += weight * b * c; q.yw += weight * b * w;
+    q.zz += weight * c * c; q.zw += weight * c * w;
+    q.ww += weight * w * w;
+    q.weight += weight;
+}
+
+static void addQuadric(Quadric & q, const Quadric & other)
+{
+    q.xx += other.xx; q.xy += other.xy; q.xz += other.xz; q.xw += other.xw;
+    q.yy += other.yy; q.yz += other.yz; q.yw += other.yw;
+    q.zz += other.zz; q.zw += other.zw;
+    q.ww += other.ww;
+    q.weight += other.weight;
+}
+
+// Weighted mean of the squared distances from p to the planes of both quadrics.
+static double getQuadricError(const Quadric & a, const Quadric & b, glm::vec3 p)
+{
+    double x = p.x, y = p.y, z = p.z;
+    double error =
+        (a.xx + b.xx) * x * x + 2 * (a.xy + b.xy) * x * y + 2 * (a.xz + b.xz) * x * z + 2 * (a.xw + b.xw) * x +
+        (a.yy + b.yy) * y * y + 2 * (a.yz + b.yz) * y * z + 2 * (a.yw + b.yw) * y +
+        (a.zz + b.zz) * z * z + 2 * (a.zw + b.zw) * z +
+        (a.ww + b.ww);
+    double weight = a.weight + b.weight;
+    return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+}
+
+// Moving position "from" onto position "to". The stamps tell whether the positions changed since the
+// collapse was queued, in which case it is dropped.
+struct Collapse
+{
+    double error;
+    unsigned int from;
+    unsigned int to;
+    unsigned int fromStamp;
+    unsigned int toStamp;
+
+    bool operator>(const Collapse & other) const
+    {
+        return error > other.error;
+    }
+};
+
+// State of the simplification. Vertices with the same position are "wedges" of one position
+// (they differ by UV or normal, along a seam) and collapse together.
+struct Simplifier
+{
+    const std::vector<InterleavedVertex> * vertices;
+    std::vector<unsigned int> triangles;            // 3 vertices per triangle
+    std::vector<bool> triangleAlive;
+    std::vector<unsigned int> positionOf;           // position of each vertex
+    std::vector<glm::vec3> positions;
+    std::vector<std::vector<unsigned int> > positionTriangles;
+    std::vector<std::vector<unsigned int> > positionWedges;
+    std::vector<Quadric> quadrics;
+    std::vector<bool> positionRemoved;
+    std::vector<unsigned int> stamps;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > queue;
+};
+
+static glm::vec3 getTriangleNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+    return glm::cross(b - a, c - a);
+}
+
+// Gives the same position to the vertices that share their position.
+static void findPositions(Simplifier & s, const std::vector<unsigned int> & used)
+{
+    const std::vector<InterleavedVertex> & vertices = *s.vertices;
+    std::vector<unsigned int> order(used);
+    std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+    {
+        const glm::vec3 & p = vertices[a].position;
+        const glm::vec3 & q = vertices[b].position;
+        if (p.x != q.x) return p.x < q.x;
+        if (p.y != q.y) return p.y < q.y;
+        return p.z < q.z;
+    });
+
+    s.positionOf.assign(vertices.size(), 0);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        if (i == 0 || !(vertices[order[i]].position == vertices[order[i - 1]].position))
+        {
+            s.positions.push_back(vertices[order[i]].position);
+            s.positionWedges.push_back(std::vector<unsigned int>());
+        }
+        s.positionOf[order[i]] = s.positions.size() - 1;
+        s.positionWedges.back().push_back(order[i]);
+    }
+}
+
+// Queues the collapses of the edges around position p, both ways.
+static void queueCollapses(Simplifier & s, unsigned int p)
+{
+    const std::vector<unsigned int> & triangles = s.positionTriangles[p];
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        unsigned int t = triangles[i];
+        if (!s.triangleAlive[t])
+        {
+            continue;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int q = s.positionOf[s.triangles[3 * t + k]];
+            if (q == p)
+            {
+                continue;
+            }
+            Collapse pq = {getQuadricError(s.quadrics[p], s.quadrics[q], s.positions[q]), p, q, s.stamps[p], s.stamps[q]};
+            Collapse qp = {getQuadricError(s.quadrics[p], s.quadrics[q], s.positions[p]), q, p, s.stamps[q], s.stamps[p]};
+            s.queue.push(pq);
+            s.queue.push(qp);
+        }
+    }
+}
+
+// Moves position "from" onto position "to" if the surface stays valid. Returns false if it doesn't.
+static bool collapse(Simplifier & s, unsigned int from, unsigned int to, unsigned int & remainingTriangles)
+{
+    const std::vector<unsigned int> & triangles = s.positionTriangles[from];
+
+    // Each wedge of "from" goes to a wedge of "to" it shares a triangle with, so the UVs and
+    // normals keep following the seams. A wedge with no such neighbour can only go to a lone wedge.
+    std::vector<unsigned int> wedgeTarget(s.positionWedges[from].size(), ~0u);
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        unsigned int t = triangles[i];
+        if (!s.triangleAlive[t])
+        {
+            continue;
+        }
+        int fromCorner = -1, toCorner = -1;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int p = s.positionOf[s.triangles[3 * t + k]];
+            fromCorner = p == from ? k : fromCorner;
+            toCorner = p == to ? k : toCorner;
+        }
+        if (fromCorner < 0 || toCorner < 0)
+        {
+            continue;
+        }
+        for (size_t w = 0; w < wedgeTarget.size(); w++)
+        {
+            if (s.positionWedges[from][w] == s.triangles[3 * t + fromCorner] && wedgeTarget[w] == ~0u)
+            {
+                wedgeTarget[w] = s.triangles[3 * t + toCorner];
+            }
+        }
+    }
+    for (size_t w = 0; w < wedgeTarget.size(); w++)
+    {
+        if (wedgeTarget[w] == ~0u)
+        {
+            if (s.positionWedges[to].size() != 1)
+            {
+                return false;
+            }
+            wedgeTarget[w] = s.positionWedges[to][0];
+        }
+    }
+
+    // The triangles that stay must not flip over.
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        unsigned int t = triangles[i];
+        if (!s.triangleAlive[t])
+        {
+            continue;
+        }
+        glm::vec3 before[3], after[3];
+        bool hasTo = false;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int p = s.positionOf[s.triangles[3 * t + k]];
+            hasTo = hasTo || p == to;
+            before[k] = s.positions[p];
+            after[k] = p == from ? s.positions[to] : s.positions[p];
+        }
+        if (hasTo)
+        {
+            continue;
+        }
+        glm::vec3 n0 = getTriangleNormal(before[0], before[1], before[2]);
+        glm::vec3 n1 = getTriangleNormal(after[0], after[1], after[2]);
+        if (glm::dot(n0, n1) <= 0.0f)
+        {
+            return false;
+        }
+    }
+
+    // Collapse : the triangles along the edge disappear, the others now use the wedges of "to".
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        unsigned int t = triangles[i];
+        if (!s.triangleAlive[t])
+        {
+            continue;
+        }
+        bool hasTo = false;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int & v = s.triangles[3 * t + k];
+            hasTo = hasTo || s.positionOf[v] == to;
+            for (size_t w = 0; w < wedgeTarget.size(); w++)
+            {
+                if (s.positionWedges[from][w] == v)
+                {
+                    v = wedgeTarget[w];
+                    break;
+                }
+            }
+        }
+        if (hasTo)
+        {
+            s.triangleAlive[t] = false;
+            remainingTriangles--;
+        }
+        else
+        {
+            s.positionTriangles[to].push_back(t);
+        }
+    }
+
+    addQuadric(s.quadrics[to], s.quadrics[from]);
+    s.positionRemoved[from] = true;
+    s.positionTriangles[from].clear();
+    s.stamps[to]++;
+    queueCollapses(s, to);
+    return true;
+}
+
+float simplifyMesh(
+    const std::vector<unsigned int> & indices,
+    const std::vector<InterleavedVertex> & vertices,
+    unsigned int targetIndexCount,
+    std::vector<unsigned int> & out_indices
+){
+    Simplifier s;
+    s.vertices = &vertices;
+    s.triangles = indices;
+    unsigned int triangleCount = indices.size() / 3;
+    s.triangleAlive.assign(triangleCount, true);
+
+    std::vector<unsigned int> used(indices);
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+    findPositions(s, used);
+
+    unsigned int positionCount = s.positions.size();
+    Quadric zero = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    s.quadrics.assign(positionCount, zero);
+    s.positionTriangles.resize(positionCount);
+    s.positionRemoved.assign(positionCount, false);
+    s.stamps.assign(positionCount, 0);
+
+    // Plane of every triangle, weighted by its area so that slivers count little.
+    // Edges are counted at the same time, to find the borders.
+    std::vector<unsigned long long> edges;
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        unsigned int p[3];
+        for (int k = 0; k < 3; k++)
+        {
+            p[k] = s.positionOf[s.triangles[3 * t + k]];
+            s.positionTriangles[p[k]].push_back(t);
+        }
+        glm::vec3 n = getTriangleNormal(s.positions[p[0]], s.positions[p[1]], s.positions[p[2]]);
+        float area = glm::length(n);
+        if (area > 0.0f)
+        {
+            n = n * (1.0f / area);
+            for (int k = 0; k < 3; k++)
+            {
+                addPlane(s.quadrics[p[k]], n, -glm::dot(n, s.positions[p[0]]), area);
+            }
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = std::min(p[k], p[(k + 1) % 3]);
+            unsigned int b = std::max(p[k], p[(k + 1) % 3]);
+            edges.push_back(((unsigned long long)a << 32) | b);
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = s.positionOf[s.triangles[3 * t + k]];
+            unsigned int b = s.positionOf[s.triangles[3 * t + (k + 1) % 3]];
+            unsigned long long key = ((unsigned long long)std::min(a, b) << 32) | std::max(a, b);
+            if (std::upper_bound(edges.begin(), edges.end(), key) - std::lower_bound(edges.begin(), edges.end(), key) != 1)
+            {
+                continue;
+            }
+            unsigned int c = s.positionOf[s.triangles[3 * t + (k + 2) % 3]];
+            glm::vec3 edge = s.positions[b] - s.positions[a];
+            glm::vec3 normal = glm::cross(edge, getTriangleNormal(s.positions[a], s.positions[b], s.positions[c]));
+            float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                normal = normal * (1.0f / length);
+                double weight = borderPlaneWeight * glm::dot(edge, edge);
+                addPlane(s.quadrics[a], normal, -glm::dot(normal, s.positions[a]), weight);
+                addPlane(s.quadrics[b], normal, -glm::dot(normal, s.positions[a]), weight);
+            }
+        }
+    }
+
+    for (unsigned int p = 0; p < positionCount; p++)
+    {
+        queueCollapses(s, p);
+    }
+
+    // Cheapest collapse first, until there are few enough triangles or nothing can be collapsed.
+    unsigned int remainingTriangles = triangleCount;
+    double maxError = 0.0;
+    while (remainingTriangles * 3 > targetIndexCount && !s.queue.empty())
+    {
+        Collapse c = s.queue.top();
+        s.queue.pop();
+        if (s.positionRemoved[c.from] || s.positionRemoved[c.to] || s.stamps[c.from] != c.fromStamp || s.stamps[c.to] != c.toStamp)
+        {
+            continue;
+        }
+        if (collapse(s, c.from, c.to, remainingTriangles))
+        {
+            maxError = std::max(maxError, c.error);
+        }
+    }
+
+    out_indices.clear();
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        if (s.triangleAlive[t])
+        {
+            out_indices.insert(out_indices.end(), &s.triangles[3 * t], &s.triangles[3 * t] + 3);
+        }
+    }
+
+    return (float)sqrt(maxError);
+}
+
+void buildLodChain(
+    const std::vector<unsigned int> & indices,
+    const std::vector<InterleavedVertex> & vertices,
+    unsigned int lodCount,
+    bool optimizeForVertexCache,
+    std::vector<unsigned int> & out_indices,
+    std::vector<MeshLod> & out_lods
+){
+    std::vector<unsigned int> level(indices);
+    float error = 0.0f;
+    for (unsigned int l = 0; l < lodCount; l++)
+    {
+        if (l > 0)
+        {
+            // Each level is simplified from the previous one, so the errors add up.
+            std::vector<unsigned int> simplified;
+            unsigned int target = (unsigned int)(level.size() / 3 * lodTriangleRatio) * 3;
+            error += simplifyMesh(level, vertices, target, simplified);
+            if (simplified.size() >= level.size())
+            {
+                // Nothing could be collapsed : more levels would all be the same.
+                break;
+            }
+            level.swap(simplified);
+        }
+
+        if (optimizeForVertexCache)
+        {
+            optimizeVertexCache(level, vertices.size());
+        }
+
+        MeshLod lod;
+        lod.firstIndex = out_indices.size();
+        lod.indexCount = level.size();
+        lod.error = error;
+        out_indices.insert(out_indices.end(), level.begin(), level.end());
+        out_lods.push_back(lod);
+    }
+}
+
+int selectLod(const MeshLod * lods, unsigned int lodCount, float distance, float pixelsPerUnit, float maxPixelError)
+{
+    // Size of one unit on the screen at this distance.
+    float pixels = pixelsPerUnit / std::max(distance, 1e-3f);
+
+    int lod = 0;
+    for (unsigned int l = 1; l < lodCount; l++)
+    {
+        if (lods[l].error * pixels <= maxPixelError)
+        {
+            lod = l;
+        }
+    }
+    return lod;
+}
@@ -0,0 +1,45 @@
+#ifndef MESHLOD_HPP
+#define MESHLOD_HPP
+
+// Number of levels of detail built for a mesh, level 0 being the mesh itself.
+#define maxLodCount 4
+
+// One level of detail : a range of the shared index buffer.
+// All levels index the same vertex buffer.
+struct MeshLod
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    float error;    // root mean square distance, in model units, from the level to the original surface
+                    // (summed over the simplifications). The largest distance is usually about twice that.
+};
+
+// Simplifies the triangles to about targetIndexCount indices by collapsing the edges that change
+// the surface the least (Garland and Heckbert's quadric error metric). Vertices are only removed,
+// never moved, so the result still indexes "vertices". Returns the largest root mean square distance
+// between a collapsed vertex and the planes of the triangles it was merged with.
+float simplifyMesh(
+    const std::vector<unsigned int> & indices,
+    const std::vector<InterleavedVertex> & vertices,
+    unsigned int targetIndexCount,
+    std::vector<unsigned int> & out_indices
+);
+
+// Appends the mesh and up to lodCount-1 simplified levels to out_indices, each level with
+// about a third of the triangles of the previous one. With optimizeForVertexCache, the triangles
+// of each level are ordered for the vertex cache (see vertexcache.hpp).
+void buildLodChain(
+    const std::vector<unsigned int> & indices,
+    const std::vector<InterleavedVertex> & vertices,
+    unsigned int lodCount,
+    bool optimizeForVertexCache,
+    std::vector<unsigned int> & out_indices,
+    std::vector<MeshLod> & out_lods
+);
+
+// Picks the coarsest level whose error covers at most maxPixelError pixels on the screen,
+// for an object at "distance" from the camera. pixelsPerUnit is the size in pixels of one unit
+// at distance 1 : viewport height / 2 * projection[1][1].
+int selectLod(const MeshLod * lods, unsigned int lodCount, float distance, float pixelsPerUnit, float maxPixelError);
+
+#endif
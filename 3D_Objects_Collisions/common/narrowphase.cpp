@@ -0,0 +1,390 @@
+/*
+Description:
+
+This file is the narrow phase of the collision detection : it checks the candidate pairs
+of the broad phase and changes the velocities of the objects that collide.
+The response is an impulse along the normal of the contact, weighted by the masses,
+so the objects bounce off each other the same way every time the same scene is run.
+The objects are either spheres, or boxes fitted to the mesh and rotated with the object,
+or the triangles of the mesh themselves behind those boxes.
+
+*/
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "broadphase.hpp"
+#include "bodystore.hpp"
+#include "taskpool.hpp"
+#include "obb.hpp"
+#include "meshbvh.hpp"
+#include "narrowphase.hpp"
+
+// Part of the overlap removed at each step. Removing all of it at once makes stacked objects jitter.
+#define contactCorrection 0.8f
+// Overlap which is not corrected at all, so objects resting on each other don't keep being pushed.
+#define contactSlop       0.01f
+
+// Fewer touching pairs than this are resolved by the calling thread alone : handing them to the pool costs more.
+#define parallelContactThreshold 2048
+// Pairs per range of parallelFor().
+#define contactGrain             512
+// Colors of the pair graph. A pair that needs more goes in the last batch, which one thread resolves.
+#define maxContactColors         64
+
+// A touching pair, with the normal and the depth its test found.
+struct PairContact
+{
+    BodyPair pair;
+    glm::vec3 normal;
+    float depth;
+};
+
+static bool isTouching(const BodyStore & bodies, const BodyPair & pair, float distance)
+{
+    unsigned int a = pair.a;
+    unsigned int b = pair.b;
+    glm::vec3 delta(bodies.posX[b] - bodies.posX[a], bodies.posY[b] - bodies.posY[a], bodies.posZ[b] - bodies.posZ[a]);
+    return glm::dot(delta, delta) < distance * distance && bodies.invMass[a] + bodies.invMass[b] > 0.0f;
+}
+
+// Pushes the objects of a pair apart by depth along normal, which points from a to b, and if they are moving
+// towards each other gives them opposite impulses. Only changes the two objects of the pair.
+static void applyContact(BodyStore & bodies, const BodyPair & pair, glm::vec3 normal, float depth, float restitution)
+{
+    unsigned int a = pair.a;
+    unsigned int b = pair.b;
+
+    float invMassA = bodies.invMass[a];
+    float invMassB = bodies.invMass[b];
+    float invMassSum = invMassA + invMassB;
+
+    // Move them apart, the lighter one more.
+    float push = std::max(depth - contactSlop, 0.0f) * contactCorrection / invMassSum;
+    bodies.posX[a] -= normal.x * push * invMassA;
+    bodies.posY[a] -= normal.y * push * invMassA;
+    bodies.posZ[a] -= normal.z * push * invMassA;
+    bodies.posX[b] += normal.x * push * invMassB;
+    bodies.posY[b] += normal.y * push * invMassB;
+    bodies.posZ[b] += normal.z * push * invMassB;
+
+    // Objects already moving apart keep their velocities.
+    glm::vec3 relative(bodies.velX[b] - bodies.velX[a], bodies.velY[b] - bodies.velY[a], bodies.velZ[b] - bodies.velZ[a]);
+    float approach = glm::dot(relative, normal);
+    if (approach >= 0.0f)
+    {
+        return;
+    }
+
+    float impulse = -(1.0f + restitution) * approach / invMassSum;
+    bodies.velX[a] -= normal.x * impulse * invMassA;
+    bodies.velY[a] -= normal.y * impulse * invMassA;
+    bodies.velZ[a] -= normal.z * impulse * invMassA;
+    bodies.velX[b] += normal.x * impulse * invMassB;
+    bodies.velY[b] += normal.y * impulse * invMassB;
+    bodies.velZ[b] += normal.z * impulse * invMassB;
+}
+
+// Tests one pair of spheres. Returns false if they don't touch.
+static bool findSphereContact(const BodyStore & bodies, const BodyPair & pair, float distance,
+                              glm::vec3 & out_normal, float & out_depth)
+{
+    unsigned int a = pair.a;
+    unsigned int b = pair.b;
+    if (bodies.invMass[a] + bodies.invMass[b] == 0.0f)
+    {
+        return false;
+    }
+
+    glm::vec3 delta(bodies.posX[b] - bodies.posX[a], bodies.posY[b] - bodies.posY[a], bodies.posZ[b] - bodies.posZ[a]);
+    float squared = glm::dot(delta, delta);
+    if (squared >= distance * distance)
+    {
+        return false;
+    }
+
+    // Normal of the contact, from a to b. Two objects exactly on top of each other are separated vertically.
+    float length = std::sqrt(squared);
+    out_normal = length > 1e-6f ? delta * (1.0f / length) : glm::vec3(0.0f, 0.0f, 1.0f);
+    out_depth = distance - length;
+    return true;
+}
+
+// Resolves one pair of spheres. Returns false if they don't touch.
+static bool resolveSphereContact(BodyStore & bodies, const BodyPair & pair, float distance, float restitution)
+{
+    glm::vec3 normal;
+    float depth;
+    if (!findSphereContact(bodies, pair, distance, normal, depth))
+    {
+        return false;
+    }
+    applyContact(bodies, pair, normal, depth, restitution);
+    return true;
+}
+
+// Tests one pair of boxes : first the bounding spheres, which rejects most pairs with a single dot product,
+// then the separating axes of the rotated boxes.
+static bool findBoxContact(const BodyStore & bodies, const BodyPair & pair, const OrientedBox & box, float radius,
+                           glm::vec3 & out_normal, float & out_depth)
+{
+    unsigned int a = pair.a;
+    unsigned int b = pair.b;
+    if (!isTouching(bodies, pair, 2.0f * radius))
+    {
+        return false;
+    }
+
+    OrientedBox boxA = transformOBB(box, getBodyRotation(bodies, a), getBodyPosition(bodies, a));
+    OrientedBox boxB = transformOBB(box, getBodyRotation(bodies, b), getBodyPosition(bodies, b));
+    return intersectOBB(boxA, boxB, out_normal, out_depth);
+}
+
+// Resolves one pair of boxes. Returns false if they don't touch.
+static bool resolveBoxContact(BodyStore & bodies, const BodyPair & pair, const OrientedBox & box, float radius, float restitution)
+{
+    glm::vec3 normal;
+    float depth;
+    if (!findBoxContact(bodies, pair, box, radius, normal, depth))
+    {
+        return false;
+    }
+    applyContact(bodies, pair, normal, depth, restitution);
+    return true;
+}
+
+// Tests one pair of meshes : the boxes, then the triangles. The normal is the one of the boxes.
+static bool findMeshContact(const BodyStore & bodies, const BodyPair & pair, const OrientedBox & box, const MeshBvh & bvh,
+                            float radius, glm::vec3 & out_normal, float & out_depth)
+{
+    float boxDepth;
+    if (!findBoxContact(bodies, pair, box, radius, out_normal, boxDepth))
+    {
+        return false;
+    }
+    glm::mat3 rotationA = getBodyRotation(bodies, pair.a);
+    glm::mat3 rotationB = getBodyRotation(bodies, pair.b);
+    glm::vec3 positionA = getBodyPosition(bodies, pair.a);
+    glm::vec3 positionB = getBodyPosition(bodies, pair.b);
+    if (!overlapMeshBvhs(bvh, rotationA, positionA, bvh, rotationB, positionB))
+    {
+        return false;
+    }
+
+    // The boxes overlap by more than the meshes : pushing them apart by that much would make the objects jump.
+    // The depth is how far a reaches past the nearest vertex of b along the normal, which is never more than the boxes.
+    float reachA = getMeshBvhSupport(bvh, glm::transpose(rotationA) * out_normal) + glm::dot(out_normal, positionA);
+    float startB = glm::dot(out_normal, positionB) - getMeshBvhSupport(bvh, glm::transpose(rotationB) * -out_normal);
+    out_depth = glm::clamp(reachA - startB, 0.0f, boxDepth);
+    return true;
+}
+
+// Resolves one pair of meshes. Returns false if they don't touch.
+static bool resolveMeshContact(BodyStore & bodies, const BodyPair & pair, const OrientedBox & box, const MeshBvh & bvh,
+                               float radius, float restitution)
+{
+    glm::vec3 normal;
+    float depth;
+    if (!findMeshContact(bodies, pair, box, bvh, radius, normal, depth))
+    {
+        return false;
+    }
+    applyContact(bodies, pair, normal, depth, restitution);
+    return true;
+}
+
+unsigned int resolveSphereContacts(BodyStore & bodies, const std::vector<BodyPair> & pairs, float distance, float restitution)
+{
+    unsigned int touching = 0;
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        touching += resolveSphereContact(bodies, pairs[p], distance, restitution);
+    }
+    return touching;
+}
+
+unsigned int resolveBoxContacts(BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                const OrientedBox & box, float radius, float restitution)
+{
+    unsigned int touching = 0;
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        touching += resolveBoxContact(bodies, pairs[p], box, radius, restitution);
+    }
+    return touching;
+}
+
+unsigned int resolveMeshContacts(BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                 const OrientedBox & box, const MeshBvh & bvh, float radius, float restitution)
+{
+    unsigned int touching = 0;
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        touching += resolveMeshContact(bodies, pairs[p], box, bvh, radius, restitution);
+    }
+    return touching;
+}
+
+static const BodyPair & getPair(const BodyPair & pair)
+{
+    return pair;
+}
+
+static const BodyPair & getPair(const PairContact & contact)
+{
+    return contact.pair;
+}
+
+// colorContactPairs() for anything getPair() gives the pair of.
+template <typename Item>
+static void colorItems(const std::vector<Item> & items, unsigned int bodyCount,
+                       std::vector<Item> & out_items, std::vector<unsigned int> & out_colorStart)
+{
+    // Greedy coloring : each pair takes the first color neither of its objects has yet.
+    std::vector<uint64_t> bodyColors(bodyCount, 0);
+    std::vector<unsigned int> pairColor(items.size());
+    unsigned int colorCount = 0;
+    for (unsigned int p = 0; p < items.size(); p++)
+    {
+        uint64_t used = bodyColors[getPair(items[p]).a] | bodyColors[getPair(items[p]).b];
+        unsigned int color = 0;
+        while (color < maxContactColors && (used >> color) & 1)
+        {
+            color++;
+        }
+        if (color < maxContactColors)
+        {
+            bodyColors[getPair(items[p]).a] |= (uint64_t)1 << color;
+            bodyColors[getPair(items[p]).b] |= (uint64_t)1 << color;
+        }
+        pairColor[p] = color;
+        colorCount = std::max(colorCount, color + 1);
+    }
+
+    // Counting sort by color, which keeps the order of the pairs inside a color.
+    out_colorStart.assign(colorCount + 1, 0);
+    for (unsigned int p = 0; p < items.size(); p++)
+    {
+        out_colorStart[pairColor[p] + 1]++;
+    }
+    for (unsigned int c = 0; c < colorCount; c++)
+    {
+        out_colorStart[c + 1] += out_colorStart[c];
+    }
+    std::vector<unsigned int> cursor(out_colorStart.begin(), out_colorStart.end() - 1);
+    out_items.resize(items.size());
+    for (unsigned int p = 0; p < items.size(); p++)
+    {
+        out_items[cursor[pairColor[p]]++] = items[p];
+    }
+}
+
+void colorContactPairs(const std::vector<BodyPair> & pairs, unsigned int bodyCount,
+                       std::vector<BodyPair> & out_pairs, std::vector<unsigned int> & out_colorStart)
+{
+    colorItems(pairs, bodyCount, out_pairs, out_colorStart);
+}
+
+// The parallel resolution of any shape. findContact(pair, normal, depth) tests a pair like findBoxContact().
+// The contacts are only found once, before any is resolved : a pair is resolved with the normal and the depth
+// it had then, even if resolving another pair of the same object moved it since.
+template <typename FindContact>
+static unsigned int resolveContactsParallel(TaskPool & pool, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                            float restitution, FindContact findContact)
+{
+    // Most candidate pairs don't touch : find the ones which do first, with all threads.
+    std::vector<PairContact> contacts(pairs.size());
+    std::vector<unsigned char> touchingFlags(pairs.size());
+    parallelFor(pool, pairs.size(), contactGrain * 8, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int p = begin; p < end; p++)
+        {
+            contacts[p].pair = pairs[p];
+            touchingFlags[p] = findContact(pairs[p], contacts[p].normal, contacts[p].depth);
+        }
+    });
+    std::vector<PairContact> touching;
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        if (touchingFlags[p])
+        {
+            touching.push_back(contacts[p]);
+        }
+    }
+
+    auto resolve = [&](const PairContact & contact)
+    {
+        applyContact(bodies, contact.pair, contact.normal, contact.depth, restitution);
+    };
+
+    if (touching.size() < parallelContactThreshold)
+    {
+        for (unsigned int p = 0; p < touching.size(); p++)
+        {
+            resolve(touching[p]);
+        }
+        return touching.size();
+    }
+
+    // The pairs of one color have no object in common, so the threads can resolve them without locks.
+    std::vector<PairContact> colored;
+    std::vector<unsigned int> colorStart;
+    colorItems(touching, bodies.count, colored, colorStart);
+
+    unsigned int colorCount = colorStart.size() - 1;
+    for (unsigned int c = 0; c < colorCount; c++)
+    {
+        const PairContact * batch = &colored[colorStart[c]];
+        unsigned int batchSize = colorStart[c + 1] - colorStart[c];
+        if (c == maxContactColors)
+        {
+            for (unsigned int p = 0; p < batchSize; p++)
+            {
+                resolve(batch[p]);
+            }
+            continue;
+        }
+        parallelFor(pool, batchSize, contactGrain, [&](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int p = begin; p < end; p++)
+            {
+                resolve(batch[p]);
+            }
+        });
+    }
+
+    return touching.size();
+}
+
+unsigned int resolveSphereContactsParallel(TaskPool & pool, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                           float distance, float restitution)
+{
+    return resolveContactsParallel(pool, bodies, pairs, restitution,
+        [&](const BodyPair & pair, glm::vec3 & normal, float & depth) { return findSphereContact(bodies, pair, distance, normal, depth); });
+}
+
+unsigned int resolveBoxContactsParallel(TaskPool & pool, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                        const OrientedBox & box, float radius, float restitution)
+{
+    return resolveContactsParallel(pool, bodies, pairs, restitution,
+        [&](const BodyPair & pair, glm::vec3 & normal, float & depth) { return findBoxContact(bodies, pair, box, radius, normal, depth); });
+}
+
+unsigned int resolveMeshContactsParallel(TaskPool & pool, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                         const OrientedBox & box, const MeshBvh & bvh, float radius, float restitution)
+{
+    return resolveContactsParallel(pool, bodies, pairs, restitution,
+        [&](const BodyPair & pair, glm::vec3 & normal, float & depth) { return findMeshContact(bodies, pair, box, bvh, radius, normal, depth); });
+}
@@ -0,0 +1,47 @@
+#ifndef NARROWPHASE_HPP
+#define NARROWPHASE_HPP
+
+// Resolves the contacts between the candidate pairs of the broad phase, one pair after the other.
+// The objects are spheres : a pair touches when the centers are closer than distance, the sum of the radii.
+// Touching objects are pushed apart along the line between their centers, and if they are moving
+// towards each other they get opposite impulses. The impulses conserve the momentum, and restitution
+// is the part of the approaching speed they keep (1 for a bounce that loses no energy).
+// Returns the number of pairs which touched.
+unsigned int resolveSphereContacts(BodyStore & bodies, const std::vector<BodyPair> & pairs, float distance, float restitution);
+
+// Sorts the pairs in batches, or colors, where no two pairs share an object, so that the pairs
+// of a batch can be resolved at the same time. colorStart[c] .. colorStart[c+1] is batch c of out_pairs.
+// The pairs that would need more than 64 colors are all put in batch 64, which may share objects.
+void colorContactPairs(const std::vector<BodyPair> & pairs, unsigned int bodyCount,
+                       std::vector<BodyPair> & out_pairs, std::vector<unsigned int> & out_colorStart);
+
+// Same as resolveSphereContacts(), with the threads of the pool : the touching pairs are found with their
+// normals and depths first, then colored, and the threads resolve one color after the other without any lock.
+// The pairs are not resolved in the same order, and with the contacts found before any of them moved the objects,
+// so the result differs slightly from resolveSphereContacts(), but it does not depend on the number of threads.
+// A few touching pairs are resolved by the calling thread alone.
+unsigned int resolveSphereContactsParallel(TaskPool & pool, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                           float distance, float restitution);
+
+// Same as resolveSphereContacts(), for objects which all have the shape of the mesh : box is the oriented box
+// of the mesh in model space, and radius the radius of its bounding sphere around the model origin.
+// Pairs whose bounding spheres overlap are tested with the separating axes of the boxes, rotated like the objects,
+// and touching boxes are pushed apart along the axis where they overlap the least.
+unsigned int resolveBoxContacts(BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                const OrientedBox & box, float radius, float restitution);
+
+// resolveBoxContacts() with the threads of the pool, like resolveSphereContactsParallel().
+unsigned int resolveBoxContactsParallel(TaskPool & pool, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                        const OrientedBox & box, float radius, float restitution);
+
+// Same as resolveBoxContacts(), but two boxes which overlap only touch if the triangles of the meshes do,
+// tested with the BVH of the mesh. The boxes then overlap by more than the meshes, so the objects are only
+// pushed apart by how much the meshes overlap along the axis of the boxes, and get the impulses along it.
+unsigned int resolveMeshContacts(BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                 const OrientedBox & box, const MeshBvh & bvh, float radius, float restitution);
+
+// resolveMeshContacts() with the threads of the pool, like resolveSphereContactsParallel().
+unsigned int resolveMeshContactsParallel(TaskPool & pool, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                                         const OrientedBox & box, const MeshBvh & bvh, float radius, float restitution);
+
+#endif
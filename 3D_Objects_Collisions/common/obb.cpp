@@ -0,0 +1,244 @@
+/*
+Description:
+
+This file bounds the mesh with an oriented box and tests two rotated boxes for overlap.
+The box follows the shape of the mesh much better than a sphere, and two boxes can be
+tested with a few dot products, without looking at the triangles.
+
+*/
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "obb.hpp"
+
+// Cross products shorter than this come from two nearly parallel edges, and are not tested.
+#define parallelEpsilon 1e-6f
+
+// Eigenvectors of a symmetric 3x3 matrix by Jacobi rotations. The columns of out_vectors are the eigenvectors.
+static void jacobiEigenvectors(double m[3][3], double out_vectors[3][3])
+{
+    for (int r = 0; r < 3; r++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            out_vectors[r][c] = (r == c) ? 1.0 : 0.0;
+        }
+    }
+
+    for (int sweep = 0; sweep < 50; sweep++)
+    {
+        double offDiagonal = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+        if (offDiagonal < 1e-20)
+        {
+            break;
+        }
+
+        // Zero out m[p][q] with a rotation of the plane (p, q).
+        for (int p = 0; p < 2; p++)
+        {
+            for (int q = p + 1; q < 3; q++)
+            {
+                if (std::fabs(m[p][q]) < 1e-30)
+                {
+                    continue;
+                }
+                double theta = (m[q][q] - m[p][p]) / (2.0 * m[p][q]);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < 3; k++)
+                {
+                    double mkp = m[k][p], mkq = m[k][q];
+                    m[k][p] = c * mkp - s * mkq;
+                    m[k][q] = s * mkp + c * mkq;
+                }
+                for (int k = 0; k < 3; k++)
+                {
+                    double mpk = m[p][k], mqk = m[q][k];
+                    m[p][k] = c * mpk - s * mqk;
+                    m[q][k] = s * mpk + c * mqk;
+                }
+                for (int k = 0; k < 3; k++)
+                {
+                    double vkp = out_vectors[k][p], vkq = out_vectors[k][q];
+                    out_vectors[k][p] = c * vkp - s * vkq;
+                    out_vectors[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+static glm::vec3 getVertexPosition(const char * vertex)
+{
+    float position[3];
+    memcpy(position, vertex, sizeof(position));
+    return glm::vec3(position[0], position[1], position[2]);
+}
+
+// Sets the center and the half extents of box to the smallest box along its axes holding all the vertices.
+static void fitBoxToAxes(const char * vertices, unsigned int vertexStride, unsigned int vertexCount, OrientedBox & box)
+{
+    glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 p = getVertexPosition(vertices + i * vertexStride);
+        for (int a = 0; a < 3; a++)
+        {
+            float projection = glm::dot(p, box.axes[a]);
+            low[a] = std::min(low[a], projection);
+            high[a] = std::max(high[a], projection);
+        }
+    }
+
+    box.center = glm::vec3(0.0f);
+    for (int a = 0; a < 3; a++)
+    {
+        box.center += box.axes[a] * (0.5f * (low[a] + high[a]));
+        box.halfExtents[a] = 0.5f * (high[a] - low[a]);
+    }
+}
+
+OrientedBox computeMeshOBB(const void * vertexData, unsigned int vertexStride, unsigned int vertexCount)
+{
+    OrientedBox box;
+    box.center = glm::vec3(0.0f);
+    box.axes[0] = glm::vec3(1.0f, 0.0f, 0.0f);
+    box.axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+    box.axes[2] = glm::vec3(0.0f, 0.0f, 1.0f);
+    box.halfExtents = glm::vec3(0.0f);
+    if (vertexCount == 0)
+    {
+        return box;
+    }
+
+    const char * vertices = (const char *)vertexData;
+
+    // Mean and covariance of the positions, in double : the sums of squares lose precision in float.
+    double mean[3] = {0.0, 0.0, 0.0};
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 p = getVertexPosition(vertices + i * vertexStride);
+        mean[0] += p.x;
+        mean[1] += p.y;
+        mean[2] += p.z;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        mean[k] /= vertexCount;
+    }
+
+    double covariance[3][3] = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 p = getVertexPosition(vertices + i * vertexStride);
+        double d[3] = {p.x - mean[0], p.y - mean[1], p.z - mean[2]};
+        for (int r = 0; r < 3; r++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                covariance[r][c] += d[r] * d[c];
+            }
+        }
+    }
+
+    double vectors[3][3];
+    jacobiEigenvectors(covariance, vectors);
+    for (int a = 0; a < 3; a++)
+    {
+        box.axes[a] = glm::normalize(glm::vec3(vectors[0][a], vectors[1][a], vectors[2][a]));
+    }
+    // Keep the axes right-handed, so the box can also be used as a rotation.
+    box.axes[2] = glm::cross(box.axes[0], box.axes[1]);
+
+    fitBoxToAxes(vertices, vertexStride, vertexCount, box);
+
+    // The principal axes are thrown off by parts sticking out of the mesh, like the ears of Suzanne :
+    // keep the box along the model axes if it is smaller.
+    OrientedBox modelBox;
+    modelBox.axes[0] = glm::vec3(1.0f, 0.0f, 0.0f);
+    modelBox.axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+    modelBox.axes[2] = glm::vec3(0.0f, 0.0f, 1.0f);
+    fitBoxToAxes(vertices, vertexStride, vertexCount, modelBox);
+
+    float volume = box.halfExtents.x * box.halfExtents.y * box.halfExtents.z;
+    float modelVolume = modelBox.halfExtents.x * modelBox.halfExtents.y * modelBox.halfExtents.z;
+    return modelVolume <= volume ? modelBox : box;
+}
+
+OrientedBox transformOBB(const OrientedBox & box, const glm::mat3 & rotation, glm::vec3 translation)
+{
+    OrientedBox result;
+    result.center = rotation * box.center + translation;
+    for (int a = 0; a < 3; a++)
+    {
+        result.axes[a] = rotation * box.axes[a];
+    }
+    result.halfExtents = box.halfExtents;
+    return result;
+}
+
+// How much the boxes overlap along axis, which must be of length 1. Negative if they are apart along it.
+static float getOverlap(const OrientedBox & a, const OrientedBox & b, glm::vec3 delta, glm::vec3 axis)
+{
+    float radiusA = 0.0f, radiusB = 0.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        radiusA += a.halfExtents[k] * std::fabs(glm::dot(a.axes[k], axis));
+        radiusB += b.halfExtents[k] * std::fabs(glm::dot(b.axes[k], axis));
+    }
+    return radiusA + radiusB - std::fabs(glm::dot(delta, axis));
+}
+
+bool intersectOBB(const OrientedBox & a, const OrientedBox & b, glm::vec3 & out_normal, float & out_depth)
+{
+    glm::vec3 delta = b.center - a.center;
+
+    glm::vec3 axes[15];
+    int axisCount = 0;
+    for (int k = 0; k < 3; k++)
+    {
+        axes[axisCount++] = a.axes[k];
+        axes[axisCount++] = b.axes[k];
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            glm::vec3 axis = glm::cross(a.axes[i], b.axes[j]);
+            float length = glm::length(axis);
+            if (length > parallelEpsilon)
+            {
+                axes[axisCount++] = axis * (1.0f / length);
+            }
+        }
+    }
+
+    // The boxes are apart if they are apart along any of the axes.
+    float bestDepth = FLT_MAX;
+    glm::vec3 bestAxis(0.0f, 0.0f, 1.0f);
+    for (int k = 0; k < axisCount; k++)
+    {
+        float overlap = getOverlap(a, b, delta, axes[k]);
+        if (overlap < 0.0f)
+        {
+            return false;
+        }
+        if (overlap < bestDepth)
+        {
+            bestDepth = overlap;
+            bestAxis = axes[k];
+        }
+    }
+
+    out_normal = glm::dot(bestAxis, delta) < 0.0f ? -bestAxis : bestAxis;
+    out_depth = bestDepth;
+    return true;
+}
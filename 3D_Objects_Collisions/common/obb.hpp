@@ -0,0 +1,27 @@
+#ifndef OBB_HPP
+#define OBB_HPP
+
+// Box of any orientation : the points center + x*axes[0] + y*axes[1] + z*axes[2]
+// with |x| <= halfExtents.x, |y| <= halfExtents.y and |z| <= halfExtents.z. The axes are orthonormal.
+struct OrientedBox
+{
+    glm::vec3 center;
+    glm::vec3 axes[3];
+    glm::vec3 halfExtents;
+};
+
+// Fits a box to the vertices of a mesh : the axes are the principal axes of the positions (the eigenvectors
+// of their covariance), and the box is as small as possible along them. If the box along the model axes is
+// smaller, that one is returned instead.
+// The position must be the first member of the vertices, as in InterleavedVertex and QuantizedVertex.
+OrientedBox computeMeshOBB(const void * vertexData, unsigned int vertexStride, unsigned int vertexCount);
+
+// The box of a mesh in model space, moved like the mesh by a rotation then a translation.
+OrientedBox transformOBB(const OrientedBox & box, const glm::mat3 & rotation, glm::vec3 translation);
+
+// Separating axis test of two boxes : the 3 axes of each box and the 9 cross products of an axis of a with an axis of b.
+// If the boxes overlap, returns true with the axis along which they overlap the least, pointing from a to b,
+// and by how much they overlap along it.
+bool intersectOBB(const OrientedBox & a, const OrientedBox & b, glm::vec3 & out_normal, float & out_depth);
+
+#endif
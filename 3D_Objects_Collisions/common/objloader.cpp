@@ -1,173 +1,382 @@
-#include <vector>
-#include <stdio.h>
-#include <string>
-#include <cstring>
-
-#include <glm/glm.hpp>
-
-#include "objloader.hpp"
-
-// Very, VERY simple OBJ loader.
-// Here is a short list of features a real function would provide : 
-// - Binary files. Reading a model should be just a few memcpy's away, not parsing a file at runtime. In short : OBJ is not very great.
-// - Animations & bones (includes bones weights)
-// - Multiple UVs
-// - All attributes should be optional, not "forced"
-// - More stable. Change a line in the OBJ file and it crashes.
-// - More secure. Change another line and you can inject code.
-// - Loading from memory, stream, etc
-
-bool loadOBJ(
-	const char * path, 
-	std::vector<glm::vec3> & out_vertices, 
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
-){
-	printf("Loading OBJ file %s...\n", path);
-
-	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices; 
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
-
-
-	FILE * file = fopen(path, "r");
-	if( file == NULL ){
-		printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
-		getchar();
-		return false;
-	}
-
-	while( 1 ){
-
-		char lineHeader[128];
-		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
-
-		// else : parse lineHeader
-		
-		if ( strcmp( lineHeader, "v" ) == 0 ){
-			glm::vec3 vertex;
-			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z );
-			temp_vertices.push_back(vertex);
-		}else if ( strcmp( lineHeader, "vt" ) == 0 ){
-			glm::vec2 uv;
-			fscanf(file, "%f %f\n", &uv.x, &uv.y );
-			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
-			temp_uvs.push_back(uv);
-		}else if ( strcmp( lineHeader, "vn" ) == 0 ){
-			glm::vec3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z );
-			temp_normals.push_back(normal);
-		}else if ( strcmp( lineHeader, "f" ) == 0 ){
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2] );
-			if (matches != 9){
-				printf("File can't be read by our simple parser :-( Try exporting with other options\n");
-				return false;
-			}
-			vertexIndices.push_back(vertexIndex[0]);
-			vertexIndices.push_back(vertexIndex[1]);
-			vertexIndices.push_back(vertexIndex[2]);
-			uvIndices    .push_back(uvIndex[0]);
-			uvIndices    .push_back(uvIndex[1]);
-			uvIndices    .push_back(uvIndex[2]);
-			normalIndices.push_back(normalIndex[0]);
-			normalIndices.push_back(normalIndex[1]);
-			normalIndices.push_back(normalIndex[2]);
-		}else{
-			// Probably a comment, eat up the rest of the line
-			char stupidBuffer[1000];
-			fgets(stupidBuffer, 1000, file);
-		}
-
-	}
-
-	// For each vertex of each triangle
-	for( unsigned int i=0; i<vertexIndices.size(); i++ ){
-
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
-		
-		// Get the attributes thanks to the index
-		glm::vec3 vertex = temp_vertices[ vertexIndex-1 ];
-		glm::vec2 uv = temp_uvs[ uvIndex-1 ];
-		glm::vec3 normal = temp_normals[ normalIndex-1 ];
-		
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs     .push_back(uv);
-		out_normals .push_back(normal);
-	
-	}
-
-	return true;
-}
-
-
-#ifdef USE_ASSIMP // don't use this #define, it's only for me (it AssImp fails to compile on your machine, at least all the other tutorials still work)
-
-// Include AssImp
-#include <assimp/Importer.hpp>      // C++ importer interface
-#include <assimp/scene.h>           // Output data structure
-#include <assimp/postprocess.h>     // Post processing flags
-
-bool loadAssImp(
-	const char * path, 
-	std::vector<unsigned short> & indices,
-	std::vector<glm::vec3> & vertices,
-	std::vector<glm::vec2> & uvs,
-	std::vector<glm::vec3> & normals
-){
-
-	Assimp::Importer importer;
-
-	const aiScene* scene = importer.ReadFile(path, 0/*aiProcess_JoinIdenticalVertices | aiProcess_SortByPType*/);
-	if( !scene) {
-		fprintf( stderr, importer.GetErrorString());
-		getchar();
-		return false;
-	}
-	const aiMesh* mesh = scene->mMeshes[0]; // In this simple example code we always use the 1rst mesh (in OBJ files there is often only one anyway)
-
-	// Fill vertices positions
-	vertices.reserve(mesh->mNumVertices);
-	for(unsigned int i=0; i<mesh->mNumVertices; i++){
-		aiVector3D pos = mesh->mVertices[i];
-		vertices.push_back(glm::vec3(pos.x, pos.y, pos.z));
-	}
-
-	// Fill vertices texture coordinates
-	uvs.reserve(mesh->mNumVertices);
-	for(unsigned int i=0; i<mesh->mNumVertices; i++){
-		aiVector3D UVW = mesh->mTextureCoords[0][i]; // Assume only 1 set of UV coords; AssImp supports 8 UV sets.
-		uvs.push_back(glm::vec2(UVW.x, UVW.y));
-	}
-
-	// Fill vertices normals
-	normals.reserve(mesh->mNumVertices);
-	for(unsigned int i=0; i<mesh->mNumVertices; i++){
-		aiVector3D n = mesh->mNormals[i];
-		normals.push_back(glm::vec3(n.x, n.y, n.z));
-	}
-
-
-	// Fill face indices
-	indices.reserve(3*mesh->mNumFaces);
-	for (unsigned int i=0; i<mesh->mNumFaces; i++){
-		// Assume the model has only triangles.
-		indices.push_back(mesh->mFaces[i].mIndices[0]);
-		indices.push_back(mesh->mFaces[i].mIndices[1]);
-		indices.push_back(mesh->mFaces[i].mIndices[2]);
-	}
-	
-	// The "scene" pointer will be deleted automatically by "importer"
-
-}
-
+#include <vector>
+#include <stdio.h>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+
+#include <glm/glm.hpp>
+
+#include "mappedfile.hpp"
+#include "objloader.hpp"
+
+// Very, VERY simple OBJ loader.
+// Here is a short list of features a real function would provide : 
+// - Binary files. Reading a model should be just a few memcpy's away, not parsing a file at runtime. In short : OBJ is not very great.
+// - Animations & bones (includes bones weights)
+// - Multiple UVs
+// - All attributes should be optional, not "forced"
+// - More stable. Change a line in the OBJ file and it crashes.
+// - More secure. Change another line and you can inject code.
+// - Loading from memory, stream, etc
+
+// Helpers of the parser. They read the file content in place, don't depend on the locale
+// (a comma decimal separator can't sneak in like with fscanf), and never go past "end".
+
+static inline bool isDigit(char c){
+	return c >= '0' && c <= '9';
+}
+
+static inline const char * skipSpaces(const char * p, const char * end){
+	while ( p < end && (*p == ' ' || *p == '\t') )
+		p++;
+	return p;
+}
+
+static inline const char * skipLine(const char * p, const char * end){
+	const char * newline = (const char *)memchr(p, '\n', end - p);
+	return newline != NULL ? newline + 1 : end;
+}
+
+// Every power of ten up to 1e22 is exact in a double.
+static const double powersOf10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parses [+-]digits[.digits][(e|E)[+-]digits]. Returns the end of the number, or NULL if there is none.
+static const char * parseFloat(const char * p, const char * end, float & out){
+	p = skipSpaces(p, end);
+
+	bool negative = false;
+	if ( p < end && (*p == '-' || *p == '+') ){
+		negative = *p == '-';
+		p++;
+	}
+
+	// The first 19 significant digits fit in the mantissa, the others only move the exponent.
+	unsigned long long mantissa = 0;
+	int significantDigits = 0;
+	int exponent = 0;
+	bool anyDigit = false;
+	for ( ; p < end && isDigit(*p); p++ ){
+		anyDigit = true;
+		if ( significantDigits < 19 ){
+			mantissa = mantissa * 10 + (*p - '0');
+			significantDigits += mantissa != 0;
+		}else{
+			exponent++;
+		}
+	}
+	if ( p < end && *p == '.' ){
+		for ( p++; p < end && isDigit(*p); p++ ){
+			anyDigit = true;
+			if ( significantDigits < 19 ){
+				mantissa = mantissa * 10 + (*p - '0');
+				significantDigits += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+	if ( !anyDigit )
+		return NULL;
+
+	if ( p < end && (*p == 'e' || *p == 'E') ){
+		const char * q = p + 1;
+		bool negativeExponent = false;
+		if ( q < end && (*q == '-' || *q == '+') ){
+			negativeExponent = *q == '-';
+			q++;
+		}
+		if ( q < end && isDigit(*q) ){
+			int value = 0;
+			for ( ; q < end && isDigit(*q); q++ ){
+				if ( value < 10000 )
+					value = value * 10 + (*q - '0');
+			}
+			exponent += negativeExponent ? -value : value;
+			p = q;
+		}
+	}
+
+	double value = (double)mantissa;
+	if ( mantissa != 0 ){
+		if ( exponent < 0 )
+			value = exponent >= -22 ? value / powersOf10[-exponent] : value / pow(10.0, -exponent);
+		else if ( exponent > 0 )
+			value = exponent <= 22 ? value * powersOf10[exponent] : value * pow(10.0, exponent);
+	}
+	out = (float)(negative ? -value : value);
+	return p;
+}
+
+// Parses an OBJ index (1-based). Returns the end of the number, or NULL if there is none.
+static const char * parseIndex(const char * p, const char * end, unsigned int & out){
+	p = skipSpaces(p, end);
+	if ( p == end || !isDigit(*p) )
+		return NULL;
+	unsigned int value = 0;
+	for ( ; p < end && isDigit(*p); p++ )
+		value = value * 10 + (*p - '0');
+	out = value;
+	return p;
+}
+
+// Parses a "v/vt/vn" corner of a face.
+static const char * parseFaceCorner(const char * p, const char * end, unsigned int & vertexIndex, unsigned int & uvIndex, unsigned int & normalIndex){
+	p = parseIndex(p, end, vertexIndex);
+	if ( p == NULL || p == end || *p != '/' )
+		return NULL;
+	p = parseIndex(p + 1, end, uvIndex);
+	if ( p == NULL || p == end || *p != '/' )
+		return NULL;
+	return parseIndex(p + 1, end, normalIndex);
+}
+
+// What one chunk of the file contains, in the order of the file.
+// The face indices are the ones written in the file : 1-based positions in the whole file.
+struct OBJChunk{
+	const char * begin;
+	const char * end;
+	bool parsed;
+	std::vector<glm::vec3> temp_vertices;
+	std::vector<glm::vec2> temp_uvs;
+	std::vector<glm::vec3> temp_normals;
+	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
+};
+
+// Parses the lines of the chunk. Like the fscanf version, anything after the expected
+// numbers of a line is ignored, and so are the lines that aren't v, vt, vn or f.
+static bool parseOBJ(OBJChunk & chunk){
+	const char * p = chunk.begin;
+	const char * end = chunk.end;
+	while ( p < end ){
+
+		// read the first word of the line
+		p = skipSpaces(p, end);
+		const char * lineHeader = p;
+		while ( p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' )
+			p++;
+		size_t length = p - lineHeader;
+
+		const char * next = p;
+		if ( length == 1 && lineHeader[0] == 'v' ){
+			glm::vec3 vertex;
+			if ( (next = parseFloat(next, end, vertex.x)) != NULL &&
+			     (next = parseFloat(next, end, vertex.y)) != NULL &&
+			     (next = parseFloat(next, end, vertex.z)) != NULL )
+				chunk.temp_vertices.push_back(vertex);
+		}else if ( length == 2 && lineHeader[0] == 'v' && lineHeader[1] == 't' ){
+			glm::vec2 uv;
+			if ( (next = parseFloat(next, end, uv.x)) != NULL &&
+			     (next = parseFloat(next, end, uv.y)) != NULL ){
+				uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
+				chunk.temp_uvs.push_back(uv);
+			}
+		}else if ( length == 2 && lineHeader[0] == 'v' && lineHeader[1] == 'n' ){
+			glm::vec3 normal;
+			if ( (next = parseFloat(next, end, normal.x)) != NULL &&
+			     (next = parseFloat(next, end, normal.y)) != NULL &&
+			     (next = parseFloat(next, end, normal.z)) != NULL )
+				chunk.temp_normals.push_back(normal);
+		}else if ( length == 1 && lineHeader[0] == 'f' ){
+			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
+			for ( int k=0; k<3 && next != NULL; k++ )
+				next = parseFaceCorner(next, end, vertexIndex[k], uvIndex[k], normalIndex[k]);
+			if ( next != NULL ){
+				chunk.vertexIndices.push_back(vertexIndex[0]);
+				chunk.vertexIndices.push_back(vertexIndex[1]);
+				chunk.vertexIndices.push_back(vertexIndex[2]);
+				chunk.uvIndices    .push_back(uvIndex[0]);
+				chunk.uvIndices    .push_back(uvIndex[1]);
+				chunk.uvIndices    .push_back(uvIndex[2]);
+				chunk.normalIndices.push_back(normalIndex[0]);
+				chunk.normalIndices.push_back(normalIndex[1]);
+				chunk.normalIndices.push_back(normalIndex[2]);
+			}
+		}
+		// else : probably a comment, the rest of the line is skipped below
+
+		if ( next == NULL )
+			return false;
+		p = skipLine(p, end);
+	}
+	return true;
+}
+
+// Below this size, a chunk isn't worth a thread.
+#define objMinChunkSize (1 << 20)
+
+// Runs task(0) .. task(count-1), each in its own thread (task 0 in the calling one).
+template <typename Task>
+static void runInParallel(unsigned int count, Task task){
+	std::vector<std::thread> threads;
+	for ( unsigned int i=1; i<count; i++ )
+		threads.push_back(std::thread(task, i));
+	task(0);
+	for ( unsigned int i=0; i<threads.size(); i++ )
+		threads[i].join();
+}
+
+bool loadOBJ(
+	const char * path, 
+	std::vector<glm::vec3> & out_vertices, 
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	printf("Loading OBJ file %s...\n", path);
+
+	// The whole file is mapped in memory and parsed in place, instead of one fscanf per token.
+	MappedFile file;
+	if( !openMappedFile(file, path) ){
+		printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
+		getchar();
+		return false;
+	}
+
+	// Split the file on line boundaries, one chunk per core.
+	unsigned int chunkCount = std::max(1u, std::thread::hardware_concurrency());
+	chunkCount = std::max(1u, std::min(chunkCount, (unsigned int)(file.size / objMinChunkSize)));
+	std::vector<OBJChunk> chunks(chunkCount);
+	const char * fileEnd = file.data + file.size;
+	for ( unsigned int c=0; c<chunkCount; c++ ){
+		chunks[c].begin = c == 0 ? file.data : chunks[c-1].end;
+		chunks[c].end = c == chunkCount-1 ? fileEnd : skipLine(file.data + file.size / chunkCount * (c+1), fileEnd);
+		chunks[c].end = std::max(chunks[c].begin, chunks[c].end);
+	}
+
+	// Each chunk is parsed on its own into local arrays.
+	runInParallel(chunkCount, [&](unsigned int c){
+		chunks[c].parsed = parseOBJ(chunks[c]);
+	});
+
+	// Prefix sums : where the arrays of each chunk go in the arrays of the whole file.
+	std::vector<size_t> vertexOffset(chunkCount+1, 0), uvOffset(chunkCount+1, 0), normalOffset(chunkCount+1, 0), indexOffset(chunkCount+1, 0);
+	bool parsed = true;
+	for ( unsigned int c=0; c<chunkCount; c++ ){
+		parsed = parsed && chunks[c].parsed;
+		vertexOffset[c+1] = vertexOffset[c] + chunks[c].temp_vertices.size();
+		uvOffset    [c+1] = uvOffset    [c] + chunks[c].temp_uvs     .size();
+		normalOffset[c+1] = normalOffset[c] + chunks[c].temp_normals .size();
+		indexOffset [c+1] = indexOffset [c] + chunks[c].vertexIndices.size();
+	}
+	if ( !parsed ){
+		closeMappedFile(file);
+		printf("File can't be read by our simple parser :-( Try exporting with other options\n");
+		return false;
+	}
+
+	std::vector<glm::vec3> temp_vertices(vertexOffset[chunkCount]);
+	std::vector<glm::vec2> temp_uvs     (uvOffset    [chunkCount]);
+	std::vector<glm::vec3> temp_normals (normalOffset[chunkCount]);
+	runInParallel(chunkCount, [&](unsigned int c){
+		std::copy(chunks[c].temp_vertices.begin(), chunks[c].temp_vertices.end(), temp_vertices.begin() + vertexOffset[c]);
+		std::copy(chunks[c].temp_uvs     .begin(), chunks[c].temp_uvs     .end(), temp_uvs     .begin() + uvOffset    [c]);
+		std::copy(chunks[c].temp_normals .begin(), chunks[c].temp_normals .end(), temp_normals .begin() + normalOffset[c]);
+	});
+
+	// Each chunk expands its own triangles, so the output keeps the order of the file.
+	size_t firstOut = out_vertices.size();
+	out_vertices.resize(firstOut + indexOffset[chunkCount]);
+	out_uvs     .resize(firstOut + indexOffset[chunkCount]);
+	out_normals .resize(firstOut + indexOffset[chunkCount]);
+	runInParallel(chunkCount, [&](unsigned int c){
+		OBJChunk & chunk = chunks[c];
+		size_t out = firstOut + indexOffset[c];
+
+		// For each vertex of each triangle
+		for( unsigned int i=0; i<chunk.vertexIndices.size(); i++ ){
+
+			// Get the indices of its attributes
+			unsigned int vertexIndex = chunk.vertexIndices[i];
+			unsigned int uvIndex = chunk.uvIndices[i];
+			unsigned int normalIndex = chunk.normalIndices[i];
+			if ( vertexIndex-1 >= temp_vertices.size() || uvIndex-1 >= temp_uvs.size() || normalIndex-1 >= temp_normals.size() ){
+				chunk.parsed = false;
+				return;
+			}
+
+			// Put the attributes in buffers
+			out_vertices[out + i] = temp_vertices[ vertexIndex-1 ];
+			out_uvs     [out + i] = temp_uvs     [ uvIndex-1 ];
+			out_normals [out + i] = temp_normals [ normalIndex-1 ];
+		}
+	});
+	closeMappedFile(file);
+
+	for ( unsigned int c=0; c<chunkCount; c++ ){
+		if ( !chunks[c].parsed ){
+			out_vertices.resize(firstOut);
+			out_uvs     .resize(firstOut);
+			out_normals .resize(firstOut);
+			printf("A face of the file refers to a vertex that doesn't exist\n");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+#ifdef USE_ASSIMP // don't use this #define, it's only for me (it AssImp fails to compile on your machine, at least all the other tutorials still work)
+
+// Include AssImp
+#include <assimp/Importer.hpp>      // C++ importer interface
+#include <assimp/scene.h>           // Output data structure
+#include <assimp/postprocess.h>     // Post processing flags
+
+bool loadAssImp(
+	const char * path, 
+	std::vector<unsigned short> & indices,
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals
+){
+
+	Assimp::Importer importer;
+
+	const aiScene* scene = importer.ReadFile(path, 0/*aiProcess_JoinIdenticalVertices | aiProcess_SortByPType*/);
+	if( !scene) {
+		fprintf( stderr, importer.GetErrorString());
+		getchar();
+		return false;
+	}
+	const aiMesh* mesh = scene->mMeshes[0]; // In this simple example code we always use the 1rst mesh (in OBJ files there is often only one anyway)
+
+	// Fill vertices positions
+	vertices.reserve(mesh->mNumVertices);
+	for(unsigned int i=0; i<mesh->mNumVertices; i++){
+		aiVector3D pos = mesh->mVertices[i];
+		vertices.push_back(glm::vec3(pos.x, pos.y, pos.z));
+	}
+
+	// Fill vertices texture coordinates
+	uvs.reserve(mesh->mNumVertices);
+	for(unsigned int i=0; i<mesh->mNumVertices; i++){
+		aiVector3D UVW = mesh->mTextureCoords[0][i]; // Assume only 1 set of UV coords; AssImp supports 8 UV sets.
+		uvs.push_back(glm::vec2(UVW.x, UVW.y));
+	}
+
+	// Fill vertices normals
+	normals.reserve(mesh->mNumVertices);
+	for(unsigned int i=0; i<mesh->mNumVertices; i++){
+		aiVector3D n = mesh->mNormals[i];
+		normals.push_back(glm::vec3(n.x, n.y, n.z));
+	}
+
+
+	// Fill face indices
+	indices.reserve(3*mesh->mNumFaces);
+	for (unsigned int i=0; i<mesh->mNumFaces; i++){
+		// Assume the model has only triangles.
+		indices.push_back(mesh->mFaces[i].mIndices[0]);
+		indices.push_back(mesh->mFaces[i].mIndices[1]);
+		indices.push_back(mesh->mFaces[i].mIndices[2]);
+	}
+	
+	// The "scene" pointer will be deleted automatically by "importer"
+
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+Description:
+
+This file runs the calculation of the objects' movements in one thread which lives 
+as long as the program, instead of creating and joining a new thread every frame.
+The thread steps the simulation while the main thread renders the previous state.
+The main thread decides how many fixed steps are needed each frame, see tutorial09_several_objects.cpp.
+
+*/
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "bodystore.hpp"
+#include "physicsworker.hpp"
+
+// Set in PhysicsWorker::ready when the buffer has not been picked up by the main thread yet.
+#define readyFresh 4
+
+static void physicsLoop(PhysicsWorker * worker)
+{
+    while (true)
+    {
+        // Take every step requested so far as one batch. The steps requested while it runs make the next batch.
+        unsigned int batch;
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->wake.wait(lock, [worker]{ return worker->pendingSteps > 0 || !worker->running; });
+            if (!worker->running)
+            {
+                return;
+            }
+            batch = worker->pendingSteps;
+            worker->pendingSteps = 0;
+        }
+
+        PhysicsSnapshot & back = worker->buffers[worker->back];
+        for (unsigned int s = 0; s < batch; s++)
+        {
+            if (s == batch - 1)
+            {
+                copyBodyStore(back.previous, worker->simulation);
+            }
+            worker->step(&worker->simulation, worker->move.load());
+            worker->stepCount++;
+        }
+
+        // Publish after every batch, the renderer never sees the steps in between.
+        // Our back buffer becomes ready, and the old ready buffer is our next back buffer.
+        copyBodyStore(back.current, worker->simulation);
+        back.step = worker->stepCount;
+        int previous = worker->ready.exchange(worker->back | readyFresh);
+        worker->back = previous & ~readyFresh;
+    }
+}
+
+void startPhysicsWorker(PhysicsWorker & worker, const BodyStore & initial, PhysicsStep step)
+{
+    worker.step = step;
+    worker.stepCount = 0;
+    initBodyStore(worker.simulation, initial.count);
+    copyBodyStore(worker.simulation, initial);
+    for (int i = 0; i < 3; i++)
+    {
+        initBodyStore(worker.buffers[i].previous, initial.count);
+        initBodyStore(worker.buffers[i].current, initial.count);
+        copyBodyStore(worker.buffers[i].previous, initial);
+        copyBodyStore(worker.buffers[i].current, initial);
+        worker.buffers[i].step = 0;
+    }
+
+    worker.front = 0;
+    worker.ready = 1;
+    worker.back = 2;
+    worker.move = 0;
+    worker.running = true;
+    worker.pendingSteps = 0;
+    worker.thread = std::thread(physicsLoop, &worker);
+}
+
+int requestPhysicsSteps(PhysicsWorker & worker, int move, int steps, int maxPendingSteps)
+{
+    worker.move = move;
+    int accepted;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        accepted = std::max(0, std::min(steps, maxPendingSteps - (int)worker.pendingSteps));
+        worker.pendingSteps += accepted;
+    }
+    worker.wake.notify_one();
+    return accepted;
+}
+
+const PhysicsSnapshot & acquireFrontSnapshot(PhysicsWorker & worker)
+{
+    // Only swap when the worker has published something new, otherwise keep drawing the same state.
+    if (worker.ready.load() & readyFresh)
+    {
+        int latest = worker.ready.exchange(worker.front);
+        worker.front = latest & ~readyFresh;
+    }
+    return worker.buffers[worker.front];
+}
+
+void stopPhysicsWorker(PhysicsWorker & worker)
+{
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.running = false;
+    }
+    worker.wake.notify_one();
+    worker.thread.join();
+}
@@ -0,0 +1,53 @@
+#ifndef PHYSICSWORKER_HPP
+#define PHYSICSWORKER_HPP
+
+// Advances the objects by one fixed step. The second argument is moveControl.
+typedef std::function<void(BodyStore *, int)> PhysicsStep;
+
+// The objects before and after the last step the worker ran, 
+// so the renderer can interpolate between them.
+struct PhysicsSnapshot
+{
+    BodyStore previous;
+    BodyStore current;
+    unsigned int step;          // number of steps done when "current" was calculated
+};
+
+// Long-lived thread that runs the simulation while the main thread renders.
+// The objects are triple-buffered : the worker writes "back", the renderer reads "front",
+// and the latest finished state waits in "ready". Handing a buffer over is a single atomic exchange,
+// so neither thread ever waits for the other one to finish with a buffer.
+struct PhysicsWorker
+{
+    PhysicsStep step;
+    BodyStore simulation;
+    unsigned int stepCount;
+    PhysicsSnapshot buffers[3];
+    int front;                  // only used by the main thread
+    int back;                   // only used by the worker thread
+    std::atomic<int> ready;     // buffer index, plus readyFresh if the worker published it after the last swap
+    std::atomic<int> move;
+    std::atomic<bool> running;
+
+    // Only used to put the worker to sleep until the next frame asks for a step.
+    std::mutex mutex;
+    std::condition_variable wake;
+    unsigned int pendingSteps;
+
+    std::thread thread;
+};
+
+// Copies the initial state into every buffer and starts the thread.
+void startPhysicsWorker(PhysicsWorker & worker, const BodyStore & initial, PhysicsStep step);
+
+// Asks the worker for more steps and returns how many it took. Returns immediately.
+// At most maxPendingSteps wait at a time : when the steps take longer than the time they simulate,
+// the extra ones are dropped instead of piling up, and the simulation runs slower than real time.
+int requestPhysicsSteps(PhysicsWorker & worker, int move, int steps, int maxPendingSteps);
+
+// Returns the latest snapshot finished by the worker. It stays valid until the next call.
+const PhysicsSnapshot & acquireFrontSnapshot(PhysicsWorker & worker);
+
+void stopPhysicsWorker(PhysicsWorker & worker);
+
+#endif
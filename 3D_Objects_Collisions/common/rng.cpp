@@ -0,0 +1,124 @@
+/*
+Description:
+
+This file generates the random numbers of the simulation.
+The numbers are the counter of a stream encrypted with the seed by the 10 rounds of Philox4x32,
+so a stream only holds a few integers, it can start anywhere without running the generator first, 
+and two streams with different ids never overlap.
+
+*/
+
+#include <stdint.h>
+
+#include "rng.hpp"
+
+#define philoxM0 0xD2511F53u
+#define philoxM1 0xCD9E8D57u
+#define philoxW0 0x9E3779B9u
+#define philoxW1 0xBB67AE85u
+
+static void mulhilo(uint32_t a, uint32_t b, uint32_t & hi, uint32_t & lo)
+{
+    uint64_t product = (uint64_t)a * b;
+    hi = (uint32_t)(product >> 32);
+    lo = (uint32_t)product;
+}
+
+// Philox4x32-10 : out = encryption of counter with key.
+static void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int round = 0; round < 10; round++)
+    {
+        uint32_t hi0, lo0, hi1, lo1;
+        mulhilo(philoxM0, c0, hi0, lo0);
+        mulhilo(philoxM1, c2, hi1, lo1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += philoxW0;
+        k1 += philoxW1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+// Generates the block at the current position and moves to the next one.
+static void nextBlock(RandomStream & stream, uint32_t out[4])
+{
+    philox(stream.counter, stream.key, out);
+    if (++stream.counter[0] == 0)
+    {
+        stream.counter[1]++;
+    }
+}
+
+// 24 random bits scaled to [0, 1) : every result is exact in a float.
+static float toUnitFloat(uint32_t x)
+{
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+void initRandomStream(RandomStream & stream, uint64_t seed, uint64_t streamId)
+{
+    stream.key[0] = (uint32_t)seed;
+    stream.key[1] = (uint32_t)(seed >> 32);
+    stream.counter[0] = 0;
+    stream.counter[1] = 0;
+    stream.counter[2] = (uint32_t)streamId;
+    stream.counter[3] = (uint32_t)(streamId >> 32);
+    stream.used = 4;
+}
+
+uint32_t nextRandom(RandomStream & stream)
+{
+    if (stream.used == 4)
+    {
+        nextBlock(stream, stream.block);
+        stream.used = 0;
+    }
+    return stream.block[stream.used++];
+}
+
+float nextRandomFloat(RandomStream & stream)
+{
+    return toUnitFloat(nextRandom(stream));
+}
+
+float nextRandomFloat(RandomStream & stream, float min, float max)
+{
+    return min + (max - min) * nextRandomFloat(stream);
+}
+
+void fillRandomFloats(RandomStream & stream, float * out, unsigned int count, float min, float max)
+{
+    float scale = max - min;
+    unsigned int i = 0;
+
+    // Use up the numbers left from the last call first, so the result is the same as calling nextRandomFloat count times.
+    for (; i < count && stream.used < 4; i++)
+    {
+        out[i] = min + scale * toUnitFloat(stream.block[stream.used++]);
+    }
+
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32_t block[4];
+        nextBlock(stream, block);
+        for (int l = 0; l < 4; l++)
+        {
+            out[i + l] = min + scale * toUnitFloat(block[l]);
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        out[i] = nextRandomFloat(stream, min, max);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+// Counter-based random numbers (Philox4x32-10, from Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// Each number is a function of the seed, the stream id and its position in the stream, so there is no
+// hidden global state : every thread uses its own stream, and the same seed gives the same numbers on every run
+// whatever the number of threads.
+struct RandomStream
+{
+    uint32_t key[2];        // the seed
+    uint32_t counter[4];    // position in the stream in [0] and [1], stream id in [2] and [3]
+    uint32_t block[4];      // the last 4 numbers generated
+    int used;               // how many of them were returned
+};
+
+void initRandomStream(RandomStream & stream, uint64_t seed, uint64_t streamId);
+
+uint32_t nextRandom(RandomStream & stream);
+
+// Uniform in [0, 1).
+float nextRandomFloat(RandomStream & stream);
+
+// Uniform in [min, max).
+float nextRandomFloat(RandomStream & stream, float min, float max);
+
+// Fills out with count numbers uniform in [min, max), 4 per call of the generator.
+void fillRandomFloats(RandomStream & stream, float * out, unsigned int count, float min, float max);
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+// Four floats processed by one instruction : SSE on x86, NEON on ARM (the M2),
+// and a plain array on anything else so the code still compiles and gives the same results.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE
+typedef __m128 float4;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SIMD_NEON
+typedef float32x4_t float4;
+#else
+#define SIMD_SCALAR
+struct float4
+{
+    float v[4];
+};
+#endif
+
+// Loads p[0..3]. p does not need to be aligned.
+inline float4 float4Load(const float * p)
+{
+#if defined(SIMD_SSE)
+    return _mm_loadu_ps(p);
+#elif defined(SIMD_NEON)
+    return vld1q_f32(p);
+#else
+    float4 r = {{p[0], p[1], p[2], p[3]}};
+    return r;
+#endif
+}
+
+inline void float4Store(float * p, float4 a)
+{
+#if defined(SIMD_SSE)
+    _mm_storeu_ps(p, a);
+#elif defined(SIMD_NEON)
+    vst1q_f32(p, a);
+#else
+    p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3];
+#endif
+}
+
+// The same value in all four lanes.
+inline float4 float4Splat(float x)
+{
+#if defined(SIMD_SSE)
+    return _mm_set1_ps(x);
+#elif defined(SIMD_NEON)
+    return vdupq_n_f32(x);
+#else
+    float4 r = {{x, x, x, x}};
+    return r;
+#endif
+}
+
+inline float4 float4Add(float4 a, float4 b)
+{
+#if defined(SIMD_SSE)
+    return _mm_add_ps(a, b);
+#elif defined(SIMD_NEON)
+    return vaddq_f32(a, b);
+#else
+    float4 r = {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+    return r;
+#endif
+}
+
+inline float4 float4Sub(float4 a, float4 b)
+{
+#if defined(SIMD_SSE)
+    return _mm_sub_ps(a, b);
+#elif defined(SIMD_NEON)
+    return vsubq_f32(a, b);
+#else
+    float4 r = {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+    return r;
+#endif
+}
+
+inline float4 float4Mul(float4 a, float4 b)
+{
+#if defined(SIMD_SSE)
+    return _mm_mul_ps(a, b);
+#elif defined(SIMD_NEON)
+    return vmulq_f32(a, b);
+#else
+    float4 r = {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+    return r;
+#endif
+}
+
+// a * b + c. Rounded twice, as two instructions, so every platform gives the same result.
+inline float4 float4MulAdd(float4 a, float4 b, float4 c)
+{
+    return float4Add(float4Mul(a, b), c);
+}
+
+inline float4 float4Min(float4 a, float4 b)
+{
+#if defined(SIMD_SSE)
+    return _mm_min_ps(a, b);
+#elif defined(SIMD_NEON)
+    return vminq_f32(a, b);
+#else
+    float4 r;
+    for (int l = 0; l < 4; l++)
+    {
+        r.v[l] = a.v[l] < b.v[l] ? a.v[l] : b.v[l];
+    }
+    return r;
+#endif
+}
+
+// Transposes the 4x4 matrix whose rows are a, b, c and d : afterwards a holds the first lanes, b the second ones...
+// Turns four values of four objects, one register per value, into one register per object.
+inline void float4Transpose(float4 & a, float4 & b, float4 & c, float4 & d)
+{
+#if defined(SIMD_SSE)
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+#elif defined(SIMD_NEON)
+    float32x4x2_t ab = vtrnq_f32(a, b);
+    float32x4x2_t cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+#else
+    float4 * rows[4] = {&a, &b, &c, &d};
+    for (int r = 0; r < 4; r++)
+    {
+        for (int l = r + 1; l < 4; l++)
+        {
+            float swap = rows[r]->v[l];
+            rows[r]->v[l] = rows[l]->v[r];
+            rows[l]->v[r] = swap;
+        }
+    }
+#endif
+}
+
+// Bit l is set if lane l of a is less than 0.
+inline int float4NegativeMask(float4 a)
+{
+#if defined(SIMD_SSE)
+    return _mm_movemask_ps(_mm_cmplt_ps(a, _mm_setzero_ps()));
+#elif defined(SIMD_NEON)
+    uint32x4_t negative = vcltq_f32(a, vdupq_n_f32(0.0f));
+    return (vgetq_lane_u32(negative, 0) & 1) | (vgetq_lane_u32(negative, 1) & 2) |
+           (vgetq_lane_u32(negative, 2) & 4) | (vgetq_lane_u32(negative, 3) & 8);
+#else
+    return (a.v[0] < 0.0f) | ((a.v[1] < 0.0f) << 1) | ((a.v[2] < 0.0f) << 2) | ((a.v[3] < 0.0f) << 3);
+#endif
+}
+
+#endif
@@ -0,0 +1,215 @@
+/*
+Description:
+
+This file puts the objects at rest to sleep, so that a scene where most objects don't move
+only costs the simulation of the ones which do.
+The objects touching each other are grouped in islands with a union-find, and an island
+only sleeps when none of its objects moves anymore.
+
+*/
+
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "broadphase.hpp"
+#include "bodystore.hpp"
+#include "sleep.hpp"
+
+// Objects closer than distance * touchMargin belong to the same island. A little more than the collision
+// distance, since objects resting against each other are pushed apart to about that distance.
+#define touchMargin 1.01f
+
+void initSleepState(SleepState & state, BodyStore & bodies)
+{
+    unsigned int count = bodies.count;
+    state.awake.resize(count);
+    state.islandNext.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        state.awake[i] = i;
+        state.islandNext[i] = i;
+        bodies.asleep[i] = 0;
+        bodies.restSteps[i] = 0;
+    }
+    state.island.assign(count, 0);
+    state.slot.assign(count, 0);
+    state.mark.assign(count, 0);
+    state.stamp = 0;
+}
+
+// A sleeping object, or one nothing can move.
+static bool isResting(const BodyStore & bodies, unsigned int i)
+{
+    return bodies.asleep[i] || bodies.invMass[i] == 0.0f;
+}
+
+void removeSleepingPairs(const BodyStore & bodies, std::vector<BodyPair> & pairs)
+{
+    unsigned int kept = 0;
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        if (!isResting(bodies, pairs[p].a) || !isResting(bodies, pairs[p].b))
+        {
+            pairs[kept++] = pairs[p];
+        }
+    }
+    pairs.resize(kept);
+}
+
+// Adds object i to this update, in an island of its own.
+static void visit(SleepState & state, unsigned int i)
+{
+    if (state.mark[i] != state.stamp)
+    {
+        state.mark[i] = state.stamp;
+        state.island[i] = i;
+        state.slot[i] = state.visited.size();
+        state.visited.push_back(i);
+    }
+}
+
+static unsigned int findIsland(SleepState & state, unsigned int i)
+{
+    while (state.island[i] != i)
+    {
+        state.island[i] = state.island[state.island[i]];
+        i = state.island[i];
+    }
+    return i;
+}
+
+static void joinIslands(SleepState & state, unsigned int a, unsigned int b)
+{
+    unsigned int islandA = findIsland(state, a);
+    unsigned int islandB = findIsland(state, b);
+    state.island[std::max(islandA, islandB)] = std::min(islandA, islandB);
+}
+
+// Brings the sleeping island of i into the update, as one island. Its members are marked awake for now,
+// they fall asleep again at the end of the update if nothing in their island moves.
+static void wakeIsland(SleepState & state, BodyStore & bodies, unsigned int i)
+{
+    if (!bodies.asleep[i])
+    {
+        return;
+    }
+    unsigned int member = i;
+    do
+    {
+        visit(state, member);
+        joinIslands(state, i, member);
+        bodies.asleep[member] = 0;
+        member = state.islandNext[member];
+    }
+    while (member != i);
+}
+
+unsigned int updateSleepStates(SleepState & state, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                               float distance, float sleepSpeed, int sleepSteps)
+{
+    // A new stamp makes every island of the last update invalid, without clearing the arrays.
+    state.stamp++;
+    state.visited.clear();
+    for (unsigned int a = 0; a < state.awake.size(); a++)
+    {
+        visit(state, state.awake[a]);
+    }
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        visit(state, pairs[p].a);
+        visit(state, pairs[p].b);
+    }
+
+    // Count the steps at rest. A sleeping object only moves if something hit it, which wakes its island up.
+    // visited grows while the islands wake up, their members are at rest and don't need to be looked at here.
+    float sleepSquared = sleepSpeed * sleepSpeed;
+    unsigned int visitedCount = state.visited.size();
+    for (unsigned int v = 0; v < visitedCount; v++)
+    {
+        unsigned int i = state.visited[v];
+        glm::vec3 velocity(bodies.velX[i], bodies.velY[i], bodies.velZ[i]);
+        if (glm::dot(velocity, velocity) > sleepSquared)
+        {
+            wakeIsland(state, bodies, i);
+            bodies.restSteps[i] = 0;
+        }
+        else if (!bodies.asleep[i])
+        {
+            bodies.restSteps[i]++;
+        }
+    }
+
+    // Join the objects in contact. A sleeping object touching an awake one joins with its whole island.
+    float touchSquared = distance * touchMargin * distance * touchMargin;
+    for (unsigned int p = 0; p < pairs.size(); p++)
+    {
+        unsigned int a = pairs[p].a;
+        unsigned int b = pairs[p].b;
+        glm::vec3 delta(bodies.posX[b] - bodies.posX[a], bodies.posY[b] - bodies.posY[a], bodies.posZ[b] - bodies.posZ[a]);
+        if (glm::dot(delta, delta) < touchSquared && bodies.invMass[a] > 0.0f && bodies.invMass[b] > 0.0f)
+        {
+            wakeIsland(state, bodies, a);
+            wakeIsland(state, bodies, b);
+            joinIslands(state, a, b);
+        }
+    }
+
+    // An island sleeps if all its objects rested long enough, else all of them are awake.
+    std::vector<int> islandRest(state.visited.size(), sleepSteps);
+    for (unsigned int v = 0; v < state.visited.size(); v++)
+    {
+        unsigned int i = state.visited[v];
+        if (!bodies.asleep[i])
+        {
+            int & rest = islandRest[state.slot[findIsland(state, i)]];
+            rest = std::min(rest, bodies.restSteps[i]);
+        }
+    }
+
+    // The islands falling asleep get new lists. The objects still asleep keep the lists of their islands.
+    for (unsigned int v = 0; v < state.visited.size(); v++)
+    {
+        unsigned int i = state.visited[v];
+        if (!bodies.asleep[i])
+        {
+            state.islandNext[i] = i;
+        }
+    }
+
+    state.awake.clear();
+    for (unsigned int v = 0; v < state.visited.size(); v++)
+    {
+        unsigned int i = state.visited[v];
+        if (bodies.invMass[i] == 0.0f || bodies.asleep[i])
+        {
+            continue;
+        }
+
+        unsigned int root = findIsland(state, i);
+        if (islandRest[state.slot[root]] >= sleepSteps)
+        {
+            // Link i into the circular list of its island, right after the root.
+            if (i != root)
+            {
+                state.islandNext[i] = state.islandNext[root];
+                state.islandNext[root] = i;
+            }
+            bodies.asleep[i] = 1;
+            bodies.velX[i] = 0.0f;
+            bodies.velY[i] = 0.0f;
+            bodies.velZ[i] = 0.0f;
+            bodies.rotSpeedX[i] = 0.0f;
+            bodies.rotSpeedY[i] = 0.0f;
+            bodies.rotSpeedZ[i] = 0.0f;
+            bodies.wallContact[i] = 0;
+        }
+        else
+        {
+            state.awake.push_back(i);
+        }
+    }
+    return state.awake.size();
+}
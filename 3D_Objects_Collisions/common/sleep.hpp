@@ -0,0 +1,35 @@
+#ifndef SLEEP_HPP
+#define SLEEP_HPP
+
+// Which objects are awake, and the islands of the sleeping ones.
+// The objects in contact with each other form islands, which fall asleep and wake up together,
+// so an object resting against another one doesn't wake up and fall asleep every other step.
+// The pairs of two sleeping objects are not looked at anymore, so the members of a sleeping island
+// are kept in a circular list (islandNext) to wake them all when one of them is touched.
+struct SleepState
+{
+    std::vector<unsigned int> awake;
+    std::vector<unsigned int> islandNext;   // next member of the sleeping island, valid while asleep
+    std::vector<unsigned int> island;       // union-find parent, valid where mark == stamp
+    std::vector<unsigned int> slot;         // position in visited, valid where mark == stamp
+    std::vector<unsigned int> mark;
+    std::vector<unsigned int> visited;      // the objects looked at by the last update
+    unsigned int stamp;
+};
+
+// Every object starts awake.
+void initSleepState(SleepState & state, BodyStore & bodies);
+
+// Removes the pairs where both objects sleep or can't move : nothing can happen between them.
+void removeSleepingPairs(const BodyStore & bodies, std::vector<BodyPair> & pairs);
+
+// Call after each step, with the pairs of the step. An object slower than sleepSpeed (in units per step)
+// counts its steps at rest. An island falls asleep when all its objects rested sleepSteps steps :
+// their velocities, rotation speeds and wall contacts are set to 0. A sleeping object which got hit,
+// or which touches an awake object, brings its whole island back into the update.
+// Only the awake objects, the objects of the pairs and their islands are looked at, so a step costs nothing
+// for the others. Returns the number of awake objects, which are listed in state.awake.
+unsigned int updateSleepStates(SleepState & state, BodyStore & bodies, const std::vector<BodyPair> & pairs,
+                               float distance, float sleepSpeed, int sleepSteps);
+
+#endif
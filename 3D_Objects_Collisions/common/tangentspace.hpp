@@ -1,15 +1,15 @@
-#ifndef TANGENTSPACE_HPP
-#define TANGENTSPACE_HPP
-
-void computeTangentBasis(
-	// inputs
-	std::vector<glm::vec3> & vertices,
-	std::vector<glm::vec2> & uvs,
-	std::vector<glm::vec3> & normals,
-	// outputs
-	std::vector<glm::vec3> & tangents,
-	std::vector<glm::vec3> & bitangents
-);
-
-
+#ifndef TANGENTSPACE_HPP
+#define TANGENTSPACE_HPP
+
+void computeTangentBasis(
+	// inputs
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::vec3> & tangents,
+	std::vector<glm::vec3> & bitangents
+);
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+/*
+Description:
+
+This file is a pool of threads which share the work of a loop.
+The ranges of a loop are spread over the queues of the threads. A thread runs the ranges of its own queue
+first and then steals from the other queues, so the work stays balanced even when some ranges take longer.
+
+*/
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+#include "taskpool.hpp"
+
+static bool popTask(PoolQueue & queue, bool fromBack, PoolTask & out_task)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+    if (fromBack)
+    {
+        out_task = queue.tasks.back();
+        queue.tasks.pop_back();
+    }
+    else
+    {
+        out_task = queue.tasks.front();
+        queue.tasks.pop_front();
+    }
+    return true;
+}
+
+// Takes a range from queue "own" first, then from the others, starting with the next one.
+static bool findTask(TaskPool & pool, unsigned int own, PoolTask & out_task)
+{
+    if (own < pool.queueCount && popTask(pool.queues[own], true, out_task))
+    {
+        return true;
+    }
+    for (unsigned int q = 1; q <= pool.queueCount; q++)
+    {
+        unsigned int victim = (own + q) % pool.queueCount;
+        if (victim != own && popTask(pool.queues[victim], false, out_task))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Takes a range of the parallelFor() call counted by remaining from any queue, the ranges of other calls are left where they are.
+static bool findCallTask(TaskPool & pool, const std::atomic<unsigned int> * remaining, PoolTask & out_task)
+{
+    for (unsigned int q = 0; q < pool.queueCount; q++)
+    {
+        PoolQueue & queue = pool.queues[q];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (std::deque<PoolTask>::iterator t = queue.tasks.begin(); t != queue.tasks.end(); ++t)
+        {
+            if (t->remaining == remaining)
+            {
+                out_task = *t;
+                queue.tasks.erase(t);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void runTask(TaskPool & pool, const PoolTask & task)
+{
+    pool.queuedTasks--;
+    (*task.task)(task.begin, task.end);
+    task.remaining->fetch_sub(1);
+}
+
+static void poolLoop(TaskPool * pool, unsigned int own)
+{
+    while (true)
+    {
+        PoolTask task;
+        if (findTask(*pool, own, task))
+        {
+            runTask(*pool, task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        pool->wake.wait(lock, [pool]{ return pool->queuedTasks > 0 || !pool->running; });
+        if (!pool->running)
+        {
+            return;
+        }
+    }
+}
+
+void startTaskPool(TaskPool & pool, unsigned int threadCount)
+{
+    if (threadCount == 0)
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    pool.queueCount = threadCount;
+    pool.queues.reset(new PoolQueue[threadCount]);
+    pool.nextQueue = 0;
+    pool.queuedTasks = 0;
+    pool.running = true;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        pool.threads.push_back(std::thread(poolLoop, &pool, t));
+    }
+}
+
+void stopTaskPool(TaskPool & pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.running = false;
+    }
+    pool.wake.notify_all();
+    for (unsigned int t = 0; t < pool.threads.size(); t++)
+    {
+        pool.threads[t].join();
+    }
+    pool.threads.clear();
+}
+
+void parallelFor(TaskPool & pool, unsigned int count, unsigned int grain, const RangeTask & task)
+{
+    grain = std::max(grain, 1u);
+    unsigned int rangeCount = (count + grain - 1) / grain;
+    if (rangeCount <= 1)
+    {
+        if (count > 0)
+        {
+            task(0, count);
+        }
+        return;
+    }
+
+    // Counted before they are queued, so a thread taking one never sees the count go below 0.
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.queuedTasks += rangeCount;
+    }
+
+    // Deal the ranges over the queues like cards, so every thread finds work in its own queue.
+    std::atomic<unsigned int> remaining(rangeCount);
+    unsigned int first = pool.nextQueue.fetch_add(1) % pool.queueCount;
+    for (unsigned int r = 0; r < rangeCount; r++)
+    {
+        PoolTask range = {&task, r * grain, std::min((r + 1) * grain, count), &remaining};
+        PoolQueue & queue = pool.queues[(first + r) % pool.queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(range);
+    }
+    pool.wake.notify_all();
+
+    // Help until the last range is finished, with the ranges of this call only : another thread calling parallelFor()
+    // on the same pool, like the render and the physics threads of the demo, must not wait for the work of this one.
+    while (remaining > 0)
+    {
+        PoolTask own;
+        if (findCallTask(pool, &remaining, own))
+        {
+            runTask(pool, own);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
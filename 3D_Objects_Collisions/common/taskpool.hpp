@@ -0,0 +1,50 @@
+#ifndef TASKPOOL_HPP
+#define TASKPOOL_HPP
+
+// The work of a parallelFor() call on the range [begin, end).
+typedef std::function<void(unsigned int, unsigned int)> RangeTask;
+
+// A range of a parallelFor() call waiting to run.
+struct PoolTask
+{
+    const RangeTask * task;
+    unsigned int begin;
+    unsigned int end;
+    std::atomic<unsigned int> * remaining;  // ranges of the call not finished yet
+};
+
+// Ranges waiting in one worker's queue. The worker takes them from the back, the others steal from the front.
+struct PoolQueue
+{
+    std::mutex mutex;
+    std::deque<PoolTask> tasks;
+};
+
+// Threads that live as long as the pool and run the ranges of parallelFor() calls.
+// Each thread has its own queue and steals from the others when it is empty, so the threads
+// don't wait on one shared queue and a thread which finishes early helps the slower ones.
+struct TaskPool
+{
+    std::vector<std::thread> threads;
+    std::unique_ptr<PoolQueue[]> queues;
+    unsigned int queueCount;
+    std::atomic<unsigned int> nextQueue;    // where the next call starts handing out its ranges
+
+    // Only used to put the threads to sleep while there is nothing to do.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<unsigned int> queuedTasks;
+    bool running;
+};
+
+// threadCount 0 uses one thread per core, minus the one calling parallelFor().
+void startTaskPool(TaskPool & pool, unsigned int threadCount);
+
+void stopTaskPool(TaskPool & pool);
+
+// Splits [0, count) in ranges of at most grain items, runs task on every range with the threads of the pool,
+// and returns when all of them are done. The calling thread runs ranges of this call too while it waits,
+// but never those of another call, so several threads can share the pool without holding each other up.
+void parallelFor(TaskPool & pool, unsigned int count, unsigned int grain, const RangeTask & task);
+
+#endif
@@ -1,177 +1,723 @@
-#include <vector>
-#include <map>
-
-#include <glm/glm.hpp>
-
-#include "vboindexer.hpp"
-
-#include <string.h> // for memcmp
-
-
-// Returns true iif v1 can be considered equal to v2
-bool is_near(float v1, float v2){
-	return fabs( v1-v2 ) < 0.01f;
-}
-
-// Searches through all already-exported vertices
-// for a similar one.
-// Similar = same position + same UVs + same normal
-bool getSimilarVertexIndex( 
-	glm::vec3 & in_vertex, 
-	glm::vec2 & in_uv, 
-	glm::vec3 & in_normal, 
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals,
-	unsigned short & result
-){
-	// Lame linear search
-	for ( unsigned int i=0; i<out_vertices.size(); i++ ){
-		if (
-			is_near( in_vertex.x , out_vertices[i].x ) &&
-			is_near( in_vertex.y , out_vertices[i].y ) &&
-			is_near( in_vertex.z , out_vertices[i].z ) &&
-			is_near( in_uv.x     , out_uvs     [i].x ) &&
-			is_near( in_uv.y     , out_uvs     [i].y ) &&
-			is_near( in_normal.x , out_normals [i].x ) &&
-			is_near( in_normal.y , out_normals [i].y ) &&
-			is_near( in_normal.z , out_normals [i].z )
-		){
-			result = i;
-			return true;
-		}
-	}
-	// No other vertex could be used instead.
-	// Looks like we'll have to add it to the VBO.
-	return false;
-}
-
-void indexVBO_slow(
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
-
-	std::vector<unsigned short> & out_indices,
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
-){
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
-
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
-
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
-		}
-	}
-}
-
-struct PackedVertex{
-	glm::vec3 position;
-	glm::vec2 uv;
-	glm::vec3 normal;
-	bool operator<(const PackedVertex that) const{
-		return memcmp((void*)this, (void*)&that, sizeof(PackedVertex))>0;
-	};
-};
-
-bool getSimilarVertexIndex_fast( 
-	PackedVertex & packed, 
-	std::map<PackedVertex,unsigned short> & VertexToOutIndex,
-	unsigned short & result
-){
-	std::map<PackedVertex,unsigned short>::iterator it = VertexToOutIndex.find(packed);
-	if ( it == VertexToOutIndex.end() ){
-		return false;
-	}else{
-		result = it->second;
-		return true;
-	}
-}
-
-void indexVBO(
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
-
-	std::vector<unsigned short> & out_indices,
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
-){
-	std::map<PackedVertex,unsigned short> VertexToOutIndex;
-
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
-
-		PackedVertex packed = {in_vertices[i], in_uvs[i], in_normals[i]};
-		
-
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex_fast( packed, VertexToOutIndex, index);
-
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			unsigned short newindex = (unsigned short)out_vertices.size() - 1;
-			out_indices .push_back( newindex );
-			VertexToOutIndex[ packed ] = newindex;
-		}
-	}
-}
-
-
-
-
-
-
-
-void indexVBO_TBN(
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
-	std::vector<glm::vec3> & in_tangents,
-	std::vector<glm::vec3> & in_bitangents,
-
-	std::vector<unsigned short> & out_indices,
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals,
-	std::vector<glm::vec3> & out_tangents,
-	std::vector<glm::vec3> & out_bitangents
-){
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
-
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
-
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-
-			// Average the tangents and the bitangents
-			out_tangents[index] += in_tangents[i];
-			out_bitangents[index] += in_bitangents[i];
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			out_tangents .push_back( in_tangents[i]);
-			out_bitangents .push_back( in_bitangents[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
-		}
-	}
-}
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "vboindexer.hpp"
+
+#include <string.h> // for memcmp
+
+
+// Tolerance of is_near(). indexVBO_TBN() hashes the positions on cells twice that size, so two
+// positions that is_near() accepts are always in the same cell or in adjacent ones.
+#define nearTolerance 0.01f
+
+// Returns true iif v1 can be considered equal to v2
+bool is_near(float v1, float v2){
+	return fabs( v1-v2 ) < nearTolerance;
+}
+
+// Searches through all already-exported vertices
+// for a similar one.
+// Similar = same position + same UVs + same normal
+bool getSimilarVertexIndex( 
+	glm::vec3 & in_vertex, 
+	glm::vec2 & in_uv, 
+	glm::vec3 & in_normal, 
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	unsigned int & result
+){
+	// Lame linear search
+	for ( unsigned int i=0; i<out_vertices.size(); i++ ){
+		if (
+			is_near( in_vertex.x , out_vertices[i].x ) &&
+			is_near( in_vertex.y , out_vertices[i].y ) &&
+			is_near( in_vertex.z , out_vertices[i].z ) &&
+			is_near( in_uv.x     , out_uvs     [i].x ) &&
+			is_near( in_uv.y     , out_uvs     [i].y ) &&
+			is_near( in_normal.x , out_normals [i].x ) &&
+			is_near( in_normal.y , out_normals [i].y ) &&
+			is_near( in_normal.z , out_normals [i].z )
+		){
+			result = i;
+			return true;
+		}
+	}
+	// No other vertex could be used instead.
+	// Looks like we'll have to add it to the VBO.
+	return false;
+}
+
+// Returns false if vertexCount vertices can't be addressed with indices of type Index.
+// With unsigned short, the indices would silently wrap after 65536 vertices.
+// The indexers check it before adding a vertex, and a call which fails gives the outputs back
+// as they were when it started, so false means nothing was written.
+template <typename Index>
+static bool checkIndexRange(size_t vertexCount){
+	return vertexCount == 0 || vertexCount - 1 <= (size_t)std::numeric_limits<Index>::max();
+}
+
+template <typename Index>
+static bool indexVBO_slow_impl(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<Index> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	size_t indexStart = out_indices.size();
+	size_t vertexStart = out_vertices.size();
+
+	// For each input vertex
+	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+
+		// Try to find a similar vertex in out_XXXX
+		unsigned int index;
+		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
+
+		if ( found ){ // A similar vertex is already in the VBO, use it instead !
+			out_indices.push_back( (Index)index );
+		}else{ // If not, it needs to be added in the output data.
+			if ( !checkIndexRange<Index>(out_vertices.size() + 1) ){
+				out_indices .resize(indexStart);
+				out_vertices.resize(vertexStart);
+				out_uvs     .resize(vertexStart);
+				out_normals .resize(vertexStart);
+				return false;
+			}
+			out_vertices.push_back( in_vertices[i]);
+			out_uvs     .push_back( in_uvs[i]);
+			out_normals .push_back( in_normals[i]);
+			out_indices .push_back( (Index)(out_vertices.size() - 1) );
+		}
+	}
+	return true;
+}
+
+bool indexVBO_slow(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	return indexVBO_slow_impl(in_vertices, in_uvs, in_normals, out_indices, out_vertices, out_uvs, out_normals);
+}
+
+bool indexVBO_slow(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	return indexVBO_slow_impl(in_vertices, in_uvs, in_normals, out_indices, out_vertices, out_uvs, out_normals);
+}
+
+// Same layout as the interleaved vertex : position, UV, normal.
+typedef InterleavedVertex PackedVertex;
+
+// Open-addressing hash table from a PackedVertex to its index in out_XXXX.
+// Slots hold index+1, 0 means empty. Collisions go to the next slot (linear probing).
+struct PackedVertexTable{
+	std::vector<unsigned int> slots;
+	std::vector<unsigned int> hashes;
+	unsigned int mask;
+};
+
+// Mixes the raw bits of the vertex, so two vertices hash the same iif they are bit-for-bit equal
+// (just like the memcmp the std::map version compared them with).
+static unsigned int hashPackedVertex(const PackedVertex & packed){
+	unsigned int words[sizeof(PackedVertex) / sizeof(unsigned int)];
+	memcpy(words, &packed, sizeof(PackedVertex));
+
+	unsigned int h = 2166136261u;
+	for ( unsigned int i=0; i<sizeof(words)/sizeof(words[0]); i++ ){
+		h ^= words[i];
+		h *= 0x9E3779B1u;
+		h ^= h >> 15;
+	}
+	return h;
+}
+
+static void initPackedVertexTable(PackedVertexTable & table, unsigned int maxVertices){
+	// At most half full, so the probe sequences stay short.
+	unsigned int size = 16;
+	while ( size < 2 * maxVertices )
+		size *= 2;
+	table.slots.assign(size, 0);
+	table.hashes.assign(size, 0);
+	table.mask = size - 1;
+}
+
+static bool getSimilarVertexIndex_fast( 
+	PackedVertex & packed, 
+	unsigned int hash,
+	PackedVertexTable & VertexToOutIndex,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	unsigned int & slot,
+	unsigned int & result
+){
+	for ( slot = hash & VertexToOutIndex.mask; VertexToOutIndex.slots[slot] != 0; slot = (slot + 1) & VertexToOutIndex.mask ){
+		unsigned int index = VertexToOutIndex.slots[slot] - 1;
+		if (
+			VertexToOutIndex.hashes[slot] == hash &&
+			memcmp(&out_vertices[index], &packed.position, sizeof(glm::vec3)) == 0 &&
+			memcmp(&out_uvs     [index], &packed.uv,       sizeof(glm::vec2)) == 0 &&
+			memcmp(&out_normals [index], &packed.normal,   sizeof(glm::vec3)) == 0
+		){
+			result = index;
+			return true;
+		}
+	}
+	// slot is now the empty slot where the vertex should be inserted.
+	return false;
+}
+
+template <typename Index>
+static bool indexVBO_impl(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<Index> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	PackedVertexTable VertexToOutIndex;
+	initPackedVertexTable(VertexToOutIndex, in_vertices.size());
+	size_t indexStart = out_indices.size();
+	size_t vertexStart = out_vertices.size();
+	out_indices.reserve(indexStart + in_vertices.size());
+
+	// For each input vertex
+	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+
+		PackedVertex packed = {in_vertices[i], in_uvs[i], in_normals[i]};
+		unsigned int hash = hashPackedVertex(packed);
+
+		// Try to find a similar vertex in out_XXXX
+		unsigned int slot;
+		unsigned int index;
+		bool found = getSimilarVertexIndex_fast( packed, hash, VertexToOutIndex, out_vertices, out_uvs, out_normals, slot, index);
+
+		if ( found ){ // A similar vertex is already in the VBO, use it instead !
+			out_indices.push_back( (Index)index );
+		}else{ // If not, it needs to be added in the output data.
+			if ( !checkIndexRange<Index>(out_vertices.size() + 1) ){
+				out_indices .resize(indexStart);
+				out_vertices.resize(vertexStart);
+				out_uvs     .resize(vertexStart);
+				out_normals .resize(vertexStart);
+				return false;
+			}
+			out_vertices.push_back( in_vertices[i]);
+			out_uvs     .push_back( in_uvs[i]);
+			out_normals .push_back( in_normals[i]);
+			Index newindex = (Index)(out_vertices.size() - 1);
+			out_indices .push_back( newindex );
+			VertexToOutIndex.slots [slot] = out_vertices.size();
+			VertexToOutIndex.hashes[slot] = hash;
+		}
+	}
+	return true;
+}
+
+bool indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	return indexVBO_impl(in_vertices, in_uvs, in_normals, out_indices, out_vertices, out_uvs, out_normals);
+}
+
+bool indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	return indexVBO_impl(in_vertices, in_uvs, in_normals, out_indices, out_vertices, out_uvs, out_normals);
+}
+
+// Like getSimilarVertexIndex_fast(), but the vertices already exported are interleaved.
+static bool getSimilarVertexIndex_interleaved( 
+	PackedVertex & packed, 
+	unsigned int hash,
+	PackedVertexTable & VertexToOutIndex,
+	std::vector<InterleavedVertex> & out_vertices,
+	unsigned int & slot,
+	unsigned int & result
+){
+	for ( slot = hash & VertexToOutIndex.mask; VertexToOutIndex.slots[slot] != 0; slot = (slot + 1) & VertexToOutIndex.mask ){
+		unsigned int index = VertexToOutIndex.slots[slot] - 1;
+		if ( VertexToOutIndex.hashes[slot] == hash && memcmp(&out_vertices[index], &packed, sizeof(PackedVertex)) == 0 ){
+			result = index;
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename Index>
+static bool indexVBO_interleaved_impl(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<Index> & out_indices,
+	std::vector<InterleavedVertex> & out_vertices
+){
+	PackedVertexTable VertexToOutIndex;
+	initPackedVertexTable(VertexToOutIndex, in_vertices.size());
+	size_t indexStart = out_indices.size();
+	size_t vertexStart = out_vertices.size();
+	out_indices.reserve(indexStart + in_vertices.size());
+
+	// The table only knows the vertices exported by this call.
+	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+
+		PackedVertex packed = {in_vertices[i], in_uvs[i], in_normals[i]};
+		unsigned int hash = hashPackedVertex(packed);
+
+		// Try to find a similar vertex in out_vertices
+		unsigned int slot;
+		unsigned int index;
+		bool found = getSimilarVertexIndex_interleaved( packed, hash, VertexToOutIndex, out_vertices, slot, index);
+
+		if ( found ){ // A similar vertex is already in the VBO, use it instead !
+			out_indices.push_back( (Index)index );
+		}else{ // If not, it needs to be added in the output data.
+			if ( !checkIndexRange<Index>(out_vertices.size() + 1) ){
+				out_indices .resize(indexStart);
+				out_vertices.resize(vertexStart);
+				return false;
+			}
+			out_vertices.push_back( packed );
+			out_indices .push_back( (Index)(out_vertices.size() - 1) );
+			VertexToOutIndex.slots [slot] = out_vertices.size();
+			VertexToOutIndex.hashes[slot] = hash;
+		}
+	}
+	return true;
+}
+
+bool indexVBO_interleaved(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<InterleavedVertex> & out_vertices
+){
+	return indexVBO_interleaved_impl(in_vertices, in_uvs, in_normals, out_indices, out_vertices);
+}
+
+bool indexVBO_interleaved(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<InterleavedVertex> & out_vertices
+){
+	return indexVBO_interleaved_impl(in_vertices, in_uvs, in_normals, out_indices, out_vertices);
+}
+
+// Maps [-1, 1] to a signed normalized integer of the given number of bits.
+static int toSignedNormalized(float value, int bits){
+	float maximum = (float)((1 << (bits - 1)) - 1);
+	float clamped = std::min(std::max(value, -1.0f), 1.0f);
+	return (int)floor(clamped * maximum + 0.5f);
+}
+
+bool quantizeVBO(
+	std::vector<InterleavedVertex> & in_vertices,
+	std::vector<QuantizedVertex> & out_vertices
+){
+	out_vertices.resize(in_vertices.size());
+	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+		const InterleavedVertex & in = in_vertices[i];
+		if ( fabs(in.uv.x) > 1.0f || fabs(in.uv.y) > 1.0f ){
+			out_vertices.clear();
+			return false;
+		}
+
+		// A normal that isn't unit length (or is null) is kept as it is, the shader normalizes it.
+		glm::vec3 normal = in.normal;
+		float length = glm::length(normal);
+		if ( length > 1.0f )
+			normal = normal * (1.0f / length);
+
+		QuantizedVertex & out = out_vertices[i];
+		out.position = in.position;
+		out.uv[0] = (short)toSignedNormalized(in.uv.x, 16);
+		out.uv[1] = (short)toSignedNormalized(in.uv.y, 16);
+		out.normal =
+			 ((unsigned int)toSignedNormalized(normal.x, 10) & 0x3FF) |
+			(((unsigned int)toSignedNormalized(normal.y, 10) & 0x3FF) << 10) |
+			(((unsigned int)toSignedNormalized(normal.z, 10) & 0x3FF) << 20);
+	}
+	return true;
+}
+
+void interleaveVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<InterleavedVertex> & out_vertices
+){
+	out_vertices.resize(in_vertices.size());
+	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+		out_vertices[i].position = in_vertices[i];
+		out_vertices[i].uv       = in_uvs[i];
+		out_vertices[i].normal   = in_normals[i];
+	}
+}
+
+bool narrowIndices(
+	const std::vector<unsigned int> & in_indices,
+	std::vector<unsigned short> & out_indices
+){
+	out_indices.clear();
+	for ( unsigned int i=0; i<in_indices.size(); i++ ){
+		if ( in_indices[i] > std::numeric_limits<unsigned short>::max() ){
+			out_indices.clear();
+			return false;
+		}
+	}
+	out_indices.assign(in_indices.begin(), in_indices.end());
+	return true;
+}
+
+
+
+
+
+
+
+template <typename Index>
+static bool indexVBO_TBN_slow_impl(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<Index> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+){
+	size_t indexStart = out_indices.size();
+	size_t vertexStart = out_vertices.size();
+
+	// The tangents of the vertices exported before the call are summed in place,
+	// so they are saved when the call can run out of indices.
+	std::vector<glm::vec3> savedTangents, savedBitangents;
+	if ( !checkIndexRange<Index>(vertexStart + in_vertices.size()) ){
+		savedTangents   = out_tangents;
+		savedBitangents = out_bitangents;
+	}
+
+	// For each input vertex
+	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+
+		// Try to find a similar vertex in out_XXXX
+		unsigned int index;
+		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
+
+		if ( found ){ // A similar vertex is already in the VBO, use it instead !
+			out_indices.push_back( (Index)index );
+
+			// Average the tangents and the bitangents
+			out_tangents[index] += in_tangents[i];
+			out_bitangents[index] += in_bitangents[i];
+		}else{ // If not, it needs to be added in the output data.
+			if ( !checkIndexRange<Index>(out_vertices.size() + 1) ){
+				out_indices .resize(indexStart);
+				out_vertices.resize(vertexStart);
+				out_uvs     .resize(vertexStart);
+				out_normals .resize(vertexStart);
+				out_tangents  .swap(savedTangents);
+				out_bitangents.swap(savedBitangents);
+				return false;
+			}
+			out_vertices.push_back( in_vertices[i]);
+			out_uvs     .push_back( in_uvs[i]);
+			out_normals .push_back( in_normals[i]);
+			out_tangents .push_back( in_tangents[i]);
+			out_bitangents .push_back( in_bitangents[i]);
+			out_indices .push_back( (Index)(out_vertices.size() - 1) );
+		}
+	}
+	return true;
+}
+
+bool indexVBO_TBN_slow(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+){
+	return indexVBO_TBN_slow_impl(in_vertices, in_uvs, in_normals, in_tangents, in_bitangents, out_indices, out_vertices, out_uvs, out_normals, out_tangents, out_bitangents);
+}
+
+bool indexVBO_TBN_slow(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+){
+	return indexVBO_TBN_slow_impl(in_vertices, in_uvs, in_normals, in_tangents, in_bitangents, out_indices, out_vertices, out_uvs, out_normals, out_tangents, out_bitangents);
+}
+
+struct PositionCell{
+	int x, y, z;
+};
+
+static PositionCell getPositionCell(const glm::vec3 & position){
+	PositionCell cell = {
+		(int)floor(position.x / (2 * nearTolerance)),
+		(int)floor(position.y / (2 * nearTolerance)),
+		(int)floor(position.z / (2 * nearTolerance))
+	};
+	return cell;
+}
+
+static unsigned int hashPositionCell(const PositionCell & cell){
+	unsigned int h = 2166136261u;
+	h = (h ^ (unsigned int)cell.x) * 0x9E3779B1u; h ^= h >> 15;
+	h = (h ^ (unsigned int)cell.y) * 0x9E3779B1u; h ^= h >> 15;
+	h = (h ^ (unsigned int)cell.z) * 0x9E3779B1u; h ^= h >> 15;
+	return h;
+}
+
+// Hash table from a position cell to the last vertex of out_XXXX added in that cell.
+// The vertices of a cell are chained through nextInCell (index+1, 0 ends the chain).
+struct PositionCellTable{
+	PackedVertexTable cells;
+	std::vector<unsigned int> nextInCell;
+};
+
+// Returns the slot of the cell in the table, or the empty slot where it should be inserted.
+static unsigned int findPositionCellSlot(
+	const PositionCell & cell,
+	unsigned int hash,
+	PositionCellTable & PositionToOutIndex,
+	std::vector<glm::vec3> & out_vertices
+){
+	PackedVertexTable & cells = PositionToOutIndex.cells;
+	unsigned int slot;
+	for ( slot = hash & cells.mask; cells.slots[slot] != 0; slot = (slot + 1) & cells.mask ){
+		if ( cells.hashes[slot] != hash )
+			continue;
+		PositionCell other = getPositionCell(out_vertices[cells.slots[slot] - 1]);
+		if ( other.x == cell.x && other.y == cell.y && other.z == cell.z )
+			break;
+	}
+	return slot;
+}
+
+// Chains out_vertices[index] in front of the other vertices of its cell.
+static void addToPositionCellTable(
+	unsigned int index,
+	PositionCellTable & PositionToOutIndex,
+	std::vector<glm::vec3> & out_vertices
+){
+	PositionCell cell = getPositionCell(out_vertices[index]);
+	unsigned int hash = hashPositionCell(cell);
+	unsigned int slot = findPositionCellSlot(cell, hash, PositionToOutIndex, out_vertices);
+	PositionToOutIndex.nextInCell.push_back( PositionToOutIndex.cells.slots[slot] );
+	PositionToOutIndex.cells.slots [slot] = index + 1;
+	PositionToOutIndex.cells.hashes[slot] = hash;
+}
+
+// Same result as getSimilarVertexIndex() : the first (lowest) similar vertex,
+// but only the 27 cells around in_vertex are searched.
+static bool getSimilarVertexIndex_fast(
+	glm::vec3 & in_vertex,
+	glm::vec2 & in_uv,
+	glm::vec3 & in_normal,
+	PositionCellTable & PositionToOutIndex,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	unsigned int & result
+){
+	PositionCell center = getPositionCell(in_vertex);
+	bool found = false;
+	for ( int dz=-1; dz<=1; dz++ ){
+		for ( int dy=-1; dy<=1; dy++ ){
+			for ( int dx=-1; dx<=1; dx++ ){
+				PositionCell cell = {center.x + dx, center.y + dy, center.z + dz};
+				unsigned int slot = findPositionCellSlot(cell, hashPositionCell(cell), PositionToOutIndex, out_vertices);
+				for ( unsigned int next = PositionToOutIndex.cells.slots[slot]; next != 0; next = PositionToOutIndex.nextInCell[next - 1] ){
+					unsigned int i = next - 1;
+					if ( found && i > result )
+						continue;
+					if (
+						is_near( in_vertex.x , out_vertices[i].x ) &&
+						is_near( in_vertex.y , out_vertices[i].y ) &&
+						is_near( in_vertex.z , out_vertices[i].z ) &&
+						is_near( in_uv.x     , out_uvs     [i].x ) &&
+						is_near( in_uv.y     , out_uvs     [i].y ) &&
+						is_near( in_normal.x , out_normals [i].x ) &&
+						is_near( in_normal.y , out_normals [i].y ) &&
+						is_near( in_normal.z , out_normals [i].z )
+					){
+						result = i;
+						found = true;
+					}
+				}
+			}
+		}
+	}
+	return found;
+}
+
+template <typename Index>
+static bool indexVBO_TBN_impl(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<Index> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+){
+	// Vertices already in out_XXXX can be reused too, like in the linear search.
+	PositionCellTable PositionToOutIndex;
+	initPackedVertexTable(PositionToOutIndex.cells, out_vertices.size() + in_vertices.size());
+	PositionToOutIndex.nextInCell.reserve(out_vertices.size() + in_vertices.size());
+	for ( unsigned int i=0; i<out_vertices.size(); i++ )
+		addToPositionCellTable(i, PositionToOutIndex, out_vertices);
+	size_t indexStart = out_indices.size();
+	size_t vertexStart = out_vertices.size();
+
+	// The tangents of the vertices exported before the call are summed in place,
+	// so they are saved when the call can run out of indices.
+	std::vector<glm::vec3> savedTangents, savedBitangents;
+	if ( !checkIndexRange<Index>(vertexStart + in_vertices.size()) ){
+		savedTangents   = out_tangents;
+		savedBitangents = out_bitangents;
+	}
+	out_indices.reserve(indexStart + in_vertices.size());
+
+	// For each input vertex
+	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+
+		// Try to find a similar vertex in out_XXXX
+		unsigned int index;
+		bool found = getSimilarVertexIndex_fast(in_vertices[i], in_uvs[i], in_normals[i],     PositionToOutIndex, out_vertices, out_uvs, out_normals, index);
+
+		if ( found ){ // A similar vertex is already in the VBO, use it instead !
+			out_indices.push_back( (Index)index );
+
+			// Average the tangents and the bitangents
+			out_tangents[index] += in_tangents[i];
+			out_bitangents[index] += in_bitangents[i];
+		}else{ // If not, it needs to be added in the output data.
+			if ( !checkIndexRange<Index>(out_vertices.size() + 1) ){
+				out_indices .resize(indexStart);
+				out_vertices.resize(vertexStart);
+				out_uvs     .resize(vertexStart);
+				out_normals .resize(vertexStart);
+				out_tangents  .swap(savedTangents);
+				out_bitangents.swap(savedBitangents);
+				return false;
+			}
+			out_vertices.push_back( in_vertices[i]);
+			out_uvs     .push_back( in_uvs[i]);
+			out_normals .push_back( in_normals[i]);
+			out_tangents .push_back( in_tangents[i]);
+			out_bitangents .push_back( in_bitangents[i]);
+			out_indices .push_back( (Index)(out_vertices.size() - 1) );
+			addToPositionCellTable(out_vertices.size() - 1, PositionToOutIndex, out_vertices);
+		}
+	}
+	return true;
+}
+
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+){
+	return indexVBO_TBN_impl(in_vertices, in_uvs, in_normals, in_tangents, in_bitangents, out_indices, out_vertices, out_uvs, out_normals, out_tangents, out_bitangents);
+}
+
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+){
+	return indexVBO_TBN_impl(in_vertices, in_uvs, in_normals, in_tangents, in_bitangents, out_indices, out_vertices, out_uvs, out_normals, out_tangents, out_bitangents);
+}
@@ -0,0 +1,250 @@
+/*
+Description:
+
+This file reorders an indexed mesh for the GPU after indexVBO.
+The vertex shader runs once per vertex that isn't in the post-transform cache, so the triangles
+are first sorted to reuse the cached vertices as much as possible, then the vertices are sorted
+in the order they are first fetched. analyzeVertexCache() measures the result on the CPU.
+
+*/
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "vboindexer.hpp"
+#include "vertexcache.hpp"
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> & indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+    // cacheTime[v] : value of "transformed" when v entered the cache.
+    // v is still cached while fewer than cacheSize vertices came in after it.
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int transformed = 0;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        unsigned int v = indices[i];
+        if (cacheTime[v] == 0 || transformed - cacheTime[v] >= cacheSize)
+        {
+            transformed++;
+            cacheTime[v] = transformed;
+        }
+    }
+
+    VertexCacheStats stats;
+    stats.acmr = indices.empty() ? 0.0f : (float)transformed / (indices.size() / 3);
+    stats.atvr = vertexCount == 0 ? 0.0f : (float)transformed / vertexCount;
+    return stats;
+}
+
+// Scores of Forsyth's article.
+#define cacheDecayPower   1.5f
+#define lastTriangleScore 0.75f
+#define valenceBoostScale 2.0f
+#define valenceBoostPower 0.5f
+
+// Valences past this one all get the score of this one.
+#define maxScoredValence 32
+
+// The scores only depend on small integers, so they are computed once instead of calling powf for every vertex.
+struct VertexScoreTables
+{
+    float cache[vertexCacheSize];
+    float valence[maxScoredValence + 1];
+};
+
+static void initVertexScoreTables(VertexScoreTables & tables)
+{
+    for (int position = 0; position < vertexCacheSize; position++)
+    {
+        if (position < 3)
+        {
+            // The vertices of the last triangle get a fixed score, so the strip doesn't just turn back on itself.
+            tables.cache[position] = lastTriangleScore;
+        }
+        else
+        {
+            float scaler = 1.0f / (vertexCacheSize - 3);
+            tables.cache[position] = powf(1.0f - (position - 3) * scaler, cacheDecayPower);
+        }
+    }
+
+    // Vertices with few triangles left are finished first, so they don't come back later as orphans.
+    tables.valence[0] = 0.0f;
+    for (int valence = 1; valence <= maxScoredValence; valence++)
+    {
+        tables.valence[valence] = valenceBoostScale * powf((float)valence, -valenceBoostPower);
+    }
+}
+
+// Score of a vertex at a position of the LRU cache (-1 = not cached) with "valence" triangles left to draw.
+static float getVertexScore(const VertexScoreTables & tables, int cachePosition, unsigned int valence)
+{
+    if (valence == 0)
+    {
+        // No triangle left : no reason to pick this vertex.
+        return -1.0f;
+    }
+
+    float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+    return score + tables.valence[std::min(valence, (unsigned int)maxScoredValence)];
+}
+
+void optimizeVertexCache(std::vector<unsigned int> & indices, unsigned int vertexCount)
+{
+    unsigned int triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangles of each vertex, in one array : vertexTriangles[triangleStart[v] .. triangleStart[v] + valence[v]].
+    // The triangles already drawn are swapped past the end, so only the remaining ones are visited.
+    std::vector<unsigned int> valence(vertexCount, 0);
+    for (unsigned int i = 0; i < triangleCount * 3; i++)
+    {
+        valence[indices[i]]++;
+    }
+    std::vector<unsigned int> triangleStart(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        triangleStart[v + 1] = triangleStart[v] + valence[v];
+    }
+    std::vector<unsigned int> vertexTriangles(triangleCount * 3);
+    std::vector<unsigned int> fill(triangleStart.begin(), triangleStart.end() - 1);
+    for (unsigned int i = 0; i < triangleCount * 3; i++)
+    {
+        vertexTriangles[fill[indices[i]]++] = i / 3;
+    }
+
+    VertexScoreTables tables;
+    initVertexScoreTables(tables);
+
+    std::vector<float> vertexScore(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        vertexScore[v] = getVertexScore(tables, -1, valence[v]);
+    }
+    std::vector<float> triangleScore(triangleCount);
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+    }
+
+    // LRU cache of the simulated GPU, with room for the 3 vertices pushed in by each triangle.
+    std::vector<int> cachePosition(vertexCount, -1);
+    unsigned int cache[vertexCacheSize + 3];
+    unsigned int cacheCount = 0;
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+    unsigned int nextUnemitted = 0;
+
+    // Start with the best triangle of the whole mesh.
+    unsigned int best = 0;
+    for (unsigned int t = 1; t < triangleCount; t++)
+    {
+        if (triangleScore[t] > triangleScore[best])
+        {
+            best = t;
+        }
+    }
+
+    for (unsigned int drawn = 0; drawn < triangleCount; drawn++)
+    {
+        emitted[best] = true;
+
+        // Draw it : its vertices lose a triangle and go to the front of the cache.
+        unsigned int newCache[vertexCacheSize + 3];
+        unsigned int newCount = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[3 * best + k];
+            output.push_back(v);
+            newCache[newCount++] = v;
+
+            unsigned int * triangles = &vertexTriangles[triangleStart[v]];
+            for (unsigned int j = 0; j < valence[v]; j++)
+            {
+                if (triangles[j] == best)
+                {
+                    std::swap(triangles[j], triangles[valence[v] - 1]);
+                    break;
+                }
+            }
+            valence[v]--;
+        }
+        for (unsigned int c = 0; c < cacheCount; c++)
+        {
+            unsigned int v = cache[c];
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+            {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Rescore the vertices of the cache (and the ones just pushed out), and their remaining triangles.
+        // The next triangle is the best one among them.
+        float bestScore = -1.0f;
+        for (unsigned int c = 0; c < newCount; c++)
+        {
+            unsigned int v = newCache[c];
+            int position = c < vertexCacheSize ? (int)c : -1;
+            cachePosition[v] = position;
+
+            float score = getVertexScore(tables, position, valence[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+
+            const unsigned int * triangles = &vertexTriangles[triangleStart[v]];
+            for (unsigned int j = 0; j < valence[v]; j++)
+            {
+                unsigned int t = triangles[j];
+                triangleScore[t] += delta;
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+        cacheCount = std::min(newCount, (unsigned int)vertexCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        // Dead end : no cached vertex has a triangle left, take the next triangle not drawn yet.
+        if (bestScore < 0.0f && drawn + 1 < triangleCount)
+        {
+            while (emitted[nextUnemitted])
+            {
+                nextUnemitted++;
+            }
+            best = nextUnemitted;
+        }
+    }
+
+    indices.swap(output);
+}
+
+void optimizeVertexFetch(std::vector<unsigned int> & indices, std::vector<InterleavedVertex> & vertices)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<InterleavedVertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        unsigned int v = indices[i];
+        if (remap[v] == unused)
+        {
+            remap[v] = reordered.size();
+            reordered.push_back(vertices[v]);
+        }
+        indices[i] = remap[v];
+    }
+
+    vertices.swap(reordered);
+}
@@ -0,0 +1,27 @@
+#ifndef VERTEXCACHE_HPP
+#define VERTEXCACHE_HPP
+
+// Size of the post-transform cache the triangles are ordered for.
+// Most GPUs keep between 16 and 32 transformed vertices.
+#define vertexCacheSize 32
+
+// How well an index buffer reuses the post-transform cache, simulated as a FIFO of cacheSize vertices.
+// ACMR : transformed vertices per triangle, 0.5 at best on a big regular mesh, 3 at worst.
+// ATVR : transformed vertices per vertex of the mesh, 1 at best.
+struct VertexCacheStats
+{
+    float acmr;
+    float atvr;
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> & indices, unsigned int vertexCount, unsigned int cacheSize);
+
+// Reorders the triangles so that consecutive triangles share vertices (Tom Forsyth's
+// "Linear-Speed Vertex Cache Optimisation"). The triangles themselves are unchanged.
+void optimizeVertexCache(std::vector<unsigned int> & indices, unsigned int vertexCount);
+
+// Renumbers the vertices in the order the triangles first use them, so the vertex fetches
+// walk the buffer forward. Vertices no triangle uses are dropped.
+void optimizeVertexFetch(std::vector<unsigned int> & indices, std::vector<InterleavedVertex> & vertices);
+
+#endif
@@ -0,0 +1,232 @@
+/*
+Description:
+
+Checks the queries of the BVH of suzanne.obj against versions which test every triangle :
+raycastMeshBvh() against raycastMeshBvh_slow(), with the same hit t and triangle,
+overlapMeshBvhs() against overlapMeshBvhs_slow(), and overlapMeshBvhSphere() against the
+closest point of every triangle, found here in another way than in meshbvh.cpp.
+The meshes are placed with seeded random rotations and translations, near enough to hit each other often.
+It returns 0 if every result matches, 1 otherwise.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <thread>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <stdint.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <common/objloader.hpp>
+#include <common/vboindexer.hpp>
+#include <common/taskpool.hpp>
+#include <common/meshbvh.hpp>
+#include <common/rng.hpp>
+
+// Queries of each kind.
+#define testRays     4000
+#define testSpheres  4000
+#define testOverlaps 200
+
+// A sphere whose surface is closer than this to the mesh may be found touching or not by either version.
+#define testSphereTolerance 1e-4f
+
+#define testSeed 20240109
+
+static glm::vec3 randomVector(RandomStream & random, float size)
+{
+    return glm::vec3(nextRandomFloat(random, -size, size), nextRandomFloat(random, -size, size), nextRandomFloat(random, -size, size));
+}
+
+static glm::mat3 randomRotation(RandomStream & random)
+{
+    glm::quat orientation(nextRandomFloat(random, -1.0f, 1.0f), nextRandomFloat(random, -1.0f, 1.0f),
+                          nextRandomFloat(random, -1.0f, 1.0f), nextRandomFloat(random, -1.0f, 1.0f));
+    return glm::mat3_cast(glm::normalize(orientation));
+}
+
+// Closest point of segment ab to p.
+static glm::vec3 closestPointOnSegment(glm::vec3 p, glm::vec3 a, glm::vec3 b)
+{
+    glm::vec3 ab = b - a;
+    float length = glm::dot(ab, ab);
+    float t = length > 0.0f ? glm::clamp(glm::dot(p - a, ab) / length, 0.0f, 1.0f) : 0.0f;
+    return a + ab * t;
+}
+
+// Distance from p to the triangle : to its plane when p projects inside it, to its closest edge otherwise.
+static float distanceToTriangle(glm::vec3 p, const BvhTriangle & triangle)
+{
+    const glm::vec3 * v = triangle.vertices;
+    glm::vec3 normal = glm::cross(v[1] - v[0], v[2] - v[0]);
+    float area = glm::dot(normal, normal);
+    if (area > 0.0f)
+    {
+        glm::vec3 projected = p - normal * (glm::dot(p - v[0], normal) / area);
+        bool inside = true;
+        for (int e = 0; e < 3; e++)
+        {
+            inside = inside && glm::dot(glm::cross(v[(e + 1) % 3] - v[e], projected - v[e]), normal) >= 0.0f;
+        }
+        if (inside)
+        {
+            return glm::length(p - projected);
+        }
+    }
+    float best = FLT_MAX;
+    for (int e = 0; e < 3; e++)
+    {
+        best = std::min(best, glm::length(p - closestPointOnSegment(p, v[e], v[(e + 1) % 3])));
+    }
+    return best;
+}
+
+// Rays from around the mesh, most of them aimed at a point near it, some limited to a random t.
+static bool compareRaycasts(const MeshBvh & bvh, RandomStream & random)
+{
+    unsigned int hits = 0, mismatches = 0;
+    for (int r = 0; r < testRays; r++)
+    {
+        glm::mat3 rotation = randomRotation(random);
+        glm::vec3 translation = randomVector(random, 1.0f);
+        glm::vec3 origin = translation + randomVector(random, 4.0f);
+        glm::vec3 target = r % 4 == 0 ? origin + randomVector(random, 1.0f) : translation + randomVector(random, 1.5f);
+        glm::vec3 direction = target - origin;
+        float maxT = r % 3 == 0 ? nextRandomFloat(random, 0.5f, 1.5f) : FLT_MAX;
+
+        float t[2] = {maxT, maxT};
+        unsigned int triangle[2] = {~0u, ~0u};
+        bool hit[2];
+        hit[0] = raycastMeshBvh_slow(bvh, rotation, translation, origin, direction, t[0], triangle[0]);
+        hit[1] = raycastMeshBvh(bvh, rotation, translation, origin, direction, t[1], triangle[1]);
+        hits += hit[0];
+        if (hit[0] != hit[1] || t[0] != t[1] || triangle[0] != triangle[1])
+        {
+            if (mismatches++ < 5)
+            {
+                printf("ray %d : slow %d t %g triangle %u, bvh %d t %g triangle %u\n", r, hit[0], t[0], triangle[0], hit[1], t[1], triangle[1]);
+            }
+        }
+    }
+    printf("raycastMeshBvh : %d rays, %u hits, %s\n", testRays, hits, mismatches == 0 ? "same" : "DIFFERENT");
+    return mismatches == 0;
+}
+
+// Spheres around the mesh, of radii from well inside to just about touching it.
+static bool compareSpheres(const MeshBvh & bvh, RandomStream & random)
+{
+    unsigned int overlaps = 0, mismatches = 0;
+    for (int s = 0; s < testSpheres; s++)
+    {
+        glm::mat3 rotation = randomRotation(random);
+        glm::vec3 translation = randomVector(random, 1.0f);
+        glm::vec3 center = translation + randomVector(random, 2.5f);
+        float radius = nextRandomFloat(random, 0.01f, 1.0f);
+
+        // The mesh in world space, as the query places it.
+        float distance = FLT_MAX;
+        glm::vec3 modelCenter = glm::transpose(rotation) * (center - translation);
+        for (unsigned int t = 0; t < bvh.triangleCount; t++)
+        {
+            distance = std::min(distance, distanceToTriangle(modelCenter, bvh.triangles[t]));
+        }
+        if (std::fabs(distance - radius) < testSphereTolerance)
+        {
+            continue;
+        }
+
+        bool expected = distance <= radius;
+        bool found = overlapMeshBvhSphere(bvh, rotation, translation, center, radius);
+        overlaps += expected;
+        if (expected != found)
+        {
+            if (mismatches++ < 5)
+            {
+                printf("sphere %d : radius %g, distance %g, bvh %d\n", s, radius, distance, found);
+            }
+        }
+    }
+    printf("overlapMeshBvhSphere : %d spheres, %u overlaps, %s\n", testSpheres, overlaps, mismatches == 0 ? "same" : "DIFFERENT");
+    return mismatches == 0;
+}
+
+// Two suzannes at random orientations, with centers up to 3 apart : from deep inside each other to apart.
+static bool compareOverlaps(const MeshBvh & bvh, RandomStream & random)
+{
+    unsigned int overlaps = 0, mismatches = 0;
+    for (int o = 0; o < testOverlaps; o++)
+    {
+        glm::mat3 rotationA = randomRotation(random);
+        glm::mat3 rotationB = randomRotation(random);
+        glm::vec3 translationA = randomVector(random, 5.0f);
+        glm::vec3 translationB = translationA + randomVector(random, 1.7f);
+
+        bool expected = overlapMeshBvhs_slow(bvh, rotationA, translationA, bvh, rotationB, translationB);
+        bool found = overlapMeshBvhs(bvh, rotationA, translationA, bvh, rotationB, translationB);
+        overlaps += expected;
+        if (expected != found)
+        {
+            if (mismatches++ < 5)
+            {
+                printf("overlap %d : slow %d, bvh %d\n", o, expected, found);
+            }
+        }
+    }
+    printf("overlapMeshBvhs : %d pairs, %u overlaps, %s\n", testOverlaps, overlaps, mismatches == 0 ? "same" : "DIFFERENT");
+    return mismatches == 0;
+}
+
+int main(void)
+{
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    if (!loadOBJ("suzanne.obj", vertices, uvs, normals))
+    {
+        fprintf(stderr, "Failed to load suzanne.obj\n");
+        return 1;
+    }
+    std::vector<unsigned int> indices;
+    std::vector<InterleavedVertex> interleaved;
+    if (!indexVBO_interleaved(vertices, uvs, normals, indices, interleaved))
+    {
+        fprintf(stderr, "Failed to index suzanne.obj\n");
+        return 1;
+    }
+
+    TaskPool pool;
+    startTaskPool(pool, 0);
+    std::vector<BvhNode> nodes;
+    std::vector<BvhTriangle> triangles;
+    buildMeshBvh(pool, &interleaved[0], sizeof(InterleavedVertex), &indices[0], indices.size(), nodes, triangles);
+    stopTaskPool(pool);
+    MeshBvh bvh = getMeshBvh(nodes, triangles);
+    printf("BVH : %u nodes over %u triangles\n", bvh.nodeCount, bvh.triangleCount);
+
+    RandomStream random;
+    initRandomStream(random, testSeed, 0);
+    bool same = true;
+    same = compareRaycasts(bvh, random) && same;
+    same = compareSpheres(bvh, random) && same;
+    same = compareOverlaps(bvh, random) && same;
+
+    if (!same)
+    {
+        fprintf(stderr, "The BVH queries and the tests of every triangle differ\n");
+        return 1;
+    }
+    printf("The BVH queries match the tests of every triangle\n");
+    return 0;
+}
@@ -0,0 +1,230 @@
+/*
+Description:
+
+Checks that indexVBO_TBN(), which only searches the position cells around each vertex,
+merges exactly the same vertices as indexVBO_TBN_slow(), which compares every vertex with all the others.
+It runs both on suzanne.obj and on generated meshes whose vertices are just inside and just outside
+the tolerance of is_near(), and right on the borders of the cells, where a missed neighbour cell would show.
+It returns 0 if every result matches, 1 otherwise.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <cmath>
+#include <stdint.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/objloader.hpp>
+#include <common/vboindexer.hpp>
+#include <common/rng.hpp>
+
+// Tolerance of is_near() in vboindexer.cpp, and the size of its position cells.
+#define testTolerance 0.01f
+#define testCellSize  (2 * testTolerance)
+
+// Seed of the generated meshes.
+#define testSeed 20240109
+
+// A mesh as loadOBJ() gives it : one entry per corner of every triangle.
+struct TestMesh
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> tangents;
+    std::vector<glm::vec3> bitangents;
+};
+
+static void addCorner(TestMesh & mesh, glm::vec3 vertex, glm::vec2 uv, glm::vec3 normal, RandomStream & random)
+{
+    mesh.vertices.push_back(vertex);
+    mesh.uvs.push_back(uv);
+    mesh.normals.push_back(normal);
+    // The tangents are summed over the merged vertices, so any value shows a vertex merged differently.
+    mesh.tangents.push_back(glm::vec3(nextRandomFloat(random, -1.0f, 1.0f), nextRandomFloat(random, -1.0f, 1.0f), 1.0f));
+    mesh.bitangents.push_back(glm::vec3(1.0f, nextRandomFloat(random, -1.0f, 1.0f), nextRandomFloat(random, -1.0f, 1.0f)));
+}
+
+// Runs both indexers with indices of type Index, from the same non-empty outputs when append is true,
+// and compares every output. Returns false and says which mesh if they differ.
+template <typename Index>
+static bool compareIndexers(TestMesh & mesh, const char * name, bool append)
+{
+    std::vector<Index> indices[2];
+    std::vector<glm::vec3> vertices[2], normals[2], tangents[2], bitangents[2];
+    std::vector<glm::vec2> uvs[2];
+    bool results[2];
+    for (int run = 0; run < 2; run++)
+    {
+        // Vertices exported before the call can be reused too.
+        if (append)
+        {
+            for (unsigned int i = 0; i < mesh.vertices.size() / 4; i += 3)
+            {
+                vertices[run].push_back(mesh.vertices[i] + glm::vec3(0.004f, -0.004f, 0.0f));
+                uvs[run].push_back(mesh.uvs[i]);
+                normals[run].push_back(mesh.normals[i]);
+                tangents[run].push_back(mesh.tangents[i]);
+                bitangents[run].push_back(mesh.bitangents[i]);
+            }
+        }
+        if (run == 0)
+        {
+            results[run] = indexVBO_TBN_slow(mesh.vertices, mesh.uvs, mesh.normals, mesh.tangents, mesh.bitangents,
+                                             indices[run], vertices[run], uvs[run], normals[run], tangents[run], bitangents[run]);
+        }
+        else
+        {
+            results[run] = indexVBO_TBN(mesh.vertices, mesh.uvs, mesh.normals, mesh.tangents, mesh.bitangents,
+                                        indices[run], vertices[run], uvs[run], normals[run], tangents[run], bitangents[run]);
+        }
+    }
+
+    bool same = results[0] == results[1] && indices[0] == indices[1] && vertices[0] == vertices[1] && uvs[0] == uvs[1] &&
+                normals[0] == normals[1] && tangents[0] == tangents[1] && bitangents[0] == bitangents[1];
+    printf("%s, %u-bit indices%s : %u corners -> %u vertices, %s\n", name, (unsigned int)sizeof(Index) * 8,
+           append ? ", appended" : "", (unsigned int)mesh.vertices.size(), (unsigned int)vertices[0].size(),
+           same ? "same" : "DIFFERENT");
+    return same;
+}
+
+static bool compareAll(TestMesh & mesh, const char * name)
+{
+    bool same = true;
+    same = compareIndexers<unsigned int>(mesh, name, false) && same;
+    same = compareIndexers<unsigned int>(mesh, name, true) && same;
+    if (mesh.vertices.size() <= 65536)
+    {
+        same = compareIndexers<unsigned short>(mesh, name, false) && same;
+    }
+    return same;
+}
+
+// Pairs of corners whose position, UV or normal differ by just less or just more than the tolerance,
+// along each component in turn, so the two indexers must agree on where is_near() stops.
+static void addToleranceCorners(TestMesh & mesh, RandomStream & random)
+{
+    const float offsets[] = {0.0f, testTolerance * 0.999f, testTolerance, testTolerance * 1.001f,
+                             -testTolerance * 0.999f, -testTolerance * 1.001f, testTolerance * 0.5f};
+    const int offsetCount = sizeof(offsets) / sizeof(offsets[0]);
+    for (int component = 0; component < 8; component++)
+    {
+        for (int o = 0; o < offsetCount; o++)
+        {
+            glm::vec3 vertex(nextRandomFloat(random, -2.0f, 2.0f), nextRandomFloat(random, -2.0f, 2.0f), nextRandomFloat(random, -2.0f, 2.0f));
+            glm::vec2 uv(nextRandomFloat(random, 0.0f, 1.0f), nextRandomFloat(random, 0.0f, 1.0f));
+            glm::vec3 normal(0.0f, 0.0f, 1.0f);
+            addCorner(mesh, vertex, uv, normal, random);
+
+            // Component 0 to 2 move the position, 3 and 4 the UV, 5 to 7 the normal.
+            if (component < 3)
+            {
+                vertex[component] += offsets[o];
+            }
+            else if (component < 5)
+            {
+                uv[component - 3] += offsets[o];
+            }
+            else
+            {
+                normal[component - 5] += offsets[o];
+            }
+            addCorner(mesh, vertex, uv, normal, random);
+        }
+    }
+}
+
+// Corners on both sides of the borders of the position cells, around 0 (where floor() of negative
+// coordinates matters) and far from it, each with neighbours up to just past the tolerance away.
+static void addCellBorderCorners(TestMesh & mesh, RandomStream & random)
+{
+    const float origins[] = {0.0f, -testCellSize, 7.0f * testCellSize, -13.0f * testCellSize, 250.0f * testCellSize};
+    const float sides[] = {-1e-6f, 0.0f, 1e-6f, -testTolerance * 0.999f, testTolerance * 0.999f, testTolerance * 1.001f};
+    const int originCount = sizeof(origins) / sizeof(origins[0]);
+    const int sideCount = sizeof(sides) / sizeof(sides[0]);
+    glm::vec2 uv(0.25f, 0.75f);
+    glm::vec3 normal(0.0f, 1.0f, 0.0f);
+    for (int o = 0; o < originCount; o++)
+    {
+        for (int a = 0; a < sideCount; a++)
+        {
+            for (int b = 0; b < sideCount; b++)
+            {
+                glm::vec3 vertex(origins[o] + sides[a], origins[o] + sides[b], origins[o] - sides[a]);
+                addCorner(mesh, vertex, uv, normal, random);
+                addCorner(mesh, vertex + glm::vec3(testTolerance * 0.999f, 0.0f, 0.0f), uv, normal, random);
+                addCorner(mesh, vertex - glm::vec3(0.0f, testTolerance * 0.999f, testTolerance * 0.999f), uv, normal, random);
+            }
+        }
+    }
+}
+
+// A grid of quads whose corners are moved by up to a little more than the tolerance,
+// so some copies of a corner merge and others don't.
+static void addJitteredGrid(TestMesh & mesh, RandomStream & random, int size)
+{
+    const int corners[6][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}};
+    float jitter = testTolerance * 1.2f;
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            for (int c = 0; c < 6; c++)
+            {
+                float px = (x + corners[c][0]) * 1.5f * testCellSize - size * testCellSize;
+                float py = (y + corners[c][1]) * 1.5f * testCellSize - size * testCellSize;
+                glm::vec3 vertex(px + nextRandomFloat(random, -jitter, jitter), py + nextRandomFloat(random, -jitter, jitter),
+                                 nextRandomFloat(random, -jitter, jitter));
+                glm::vec2 uv(px + nextRandomFloat(random, -jitter, jitter), py);
+                glm::vec3 normal(nextRandomFloat(random, -jitter, jitter), nextRandomFloat(random, -jitter, jitter), 1.0f);
+                addCorner(mesh, vertex, uv, normal, random);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    RandomStream random;
+    initRandomStream(random, testSeed, 0);
+    bool same = true;
+
+    TestMesh suzanne;
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    if (!loadOBJ("suzanne.obj", vertices, uvs, normals))
+    {
+        fprintf(stderr, "Failed to load suzanne.obj\n");
+        return 1;
+    }
+    for (unsigned int i = 0; i < vertices.size(); i++)
+    {
+        addCorner(suzanne, vertices[i], uvs[i], normals[i], random);
+    }
+    same = compareAll(suzanne, "suzanne.obj") && same;
+
+    TestMesh tolerance;
+    addToleranceCorners(tolerance, random);
+    same = compareAll(tolerance, "tolerance") && same;
+
+    TestMesh borders;
+    addCellBorderCorners(borders, random);
+    same = compareAll(borders, "cell borders") && same;
+
+    TestMesh grid;
+    addJitteredGrid(grid, random, 60);
+    same = compareAll(grid, "jittered grid") && same;
+
+    if (!same)
+    {
+        fprintf(stderr, "indexVBO_TBN and indexVBO_TBN_slow differ\n");
+        return 1;
+    }
+    printf("indexVBO_TBN and indexVBO_TBN_slow match\n");
+    return 0;
+}
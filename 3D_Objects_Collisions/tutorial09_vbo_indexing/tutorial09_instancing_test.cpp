@@ -0,0 +1,431 @@
+/*
+Description:
+
+Draws the same objects once one by one with StandardShading.vertexshader and once with one instanced call
+with StandardShadingInstanced.vertexshader, and checks that both give the same picture.
+Before that, it checks that buildInstances() builds the same instances as buildInstances_slow(),
+for counts which are not a multiple of 4 and ranges longer than instanceGrain.
+It opens a hidden window and draws into a framebuffer object. GLFW still needs a display for the window,
+xvfb-run gives it one, and with Mesa, LIBGL_ALWAYS_SOFTWARE=1 draws with the software rasterizer.
+It returns 0 if the instances and the pictures match, 1 if they don't, and testSkipped if there is no display
+or the context can't draw instances.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <thread>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+
+// Include GLEW
+#include <GL/glew.h>
+
+// Include GLFW
+#include <glfw3.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+using namespace glm;
+
+#include <common/shader.hpp>
+#include <common/texture.hpp>
+#include <common/objloader.hpp>
+#include <common/mappedfile.hpp>
+#include <common/vboindexer.hpp>
+#include <common/taskpool.hpp>
+#include <common/bodystore.hpp>
+#include <common/glstate.hpp>
+#include <common/instancing.hpp>
+#include <common/rng.hpp>
+
+// Size of the picture.
+#define testWidth  256
+#define testHeight 256
+
+// Returned when the test can't run, so CTest reports it as skipped.
+#define testSkipped 77
+
+// Two pixels match when no channel differs by more than this. The pixels where they don't
+// must be fewer than maxMismatchFraction of the picture, for the triangle edges rasterized differently.
+#define channelTolerance    2
+#define maxMismatchFraction 0.001f
+
+// Two instance values match when they differ by no more than this, relative to the larger of them and 1 :
+// buildInstances() may fuse the multiplies and adds of the matrix product that glm rounds one by one.
+#define instanceTolerance 1e-5f
+
+#define testSeed 20240109u
+
+// The handles of one of the two programs.
+struct TestProgram
+{
+    GLuint program;
+    GLuint positionID;
+    GLuint uvID;
+    GLuint normalID;
+    GLint viewMatrixID;
+    GLint lightID;
+    GLint textureID;
+    GLint justGreenID;
+};
+
+static bool loadTestProgram(TestProgram & out, const char * vertexShader)
+{
+    out.program = LoadShaders(vertexShader, "StandardShading.fragmentshader");
+    if (out.program == 0)
+    {
+        return false;
+    }
+    out.positionID = glGetAttribLocation(out.program, "vertexPosition_modelspace");
+    out.uvID = glGetAttribLocation(out.program, "vertexUV");
+    out.normalID = glGetAttribLocation(out.program, "vertexNormal_modelspace");
+    out.viewMatrixID = glGetUniformLocation(out.program, "V");
+    out.lightID = glGetUniformLocation(out.program, "LightPosition_worldspace");
+    out.textureID = glGetUniformLocation(out.program, "myTextureSampler");
+    out.justGreenID = glGetUniformLocation(out.program, "JustGreen");
+    return true;
+}
+
+// Sets what both programs share and enables the attributes of the mesh.
+static void beginTestDraw(GLStateCache & state, const TestProgram & program, const glm::mat4 & view, GLuint texture,
+                          GLuint vertexbuffer, GLuint elementbuffer)
+{
+    cachedUseProgram(state, program.program);
+    cachedUniformMatrix4fv(state, program.viewMatrixID, &view[0][0]);
+    cachedUniform3f(state, program.lightID, 0.0f, 0.0f, 25.0f);
+    cachedActiveTexture(state, GL_TEXTURE0);
+    cachedBindTexture2D(state, texture);
+    cachedUniform1i(state, program.textureID, 0);
+    cachedUniform1i(state, program.justGreenID, 0);
+
+    cachedEnableVertexAttribArray(state, program.positionID);
+    cachedEnableVertexAttribArray(state, program.uvID);
+    cachedEnableVertexAttribArray(state, program.normalID);
+    cachedBindBuffer(state, GL_ARRAY_BUFFER, vertexbuffer);
+    GLsizei stride = sizeof(InterleavedVertex);
+    cachedVertexAttribPointer(state, program.positionID, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(InterleavedVertex, position));
+    cachedVertexAttribPointer(state, program.uvID, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(InterleavedVertex, uv));
+    cachedVertexAttribPointer(state, program.normalID, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(InterleavedVertex, normal));
+    cachedBindBuffer(state, GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+}
+
+static void endTestDraw(GLStateCache & state, const TestProgram & program)
+{
+    cachedDisableVertexAttribArray(state, program.positionID);
+    cachedDisableVertexAttribArray(state, program.uvID);
+    cachedDisableVertexAttribArray(state, program.normalID);
+}
+
+static void readPicture(std::vector<unsigned char> & out_pixels)
+{
+    out_pixels.resize(testWidth * testHeight * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, testWidth, testHeight, GL_RGBA, GL_UNSIGNED_BYTE, &out_pixels[0]);
+}
+
+static bool samePixel(const unsigned char * a, const unsigned char * b)
+{
+    for (int c = 0; c < 4; c++)
+    {
+        if (std::abs((int)a[c] - (int)b[c]) > channelTolerance)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sameValues(const float * a, const float * b, int count)
+{
+    for (int v = 0; v < count; v++)
+    {
+        float scale = std::max(1.0f, std::max(std::fabs(a[v]), std::fabs(b[v])));
+        if (std::fabs(a[v] - b[v]) > instanceTolerance * scale)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Objects at random places and orientations, taken in a random order like the sorted order of the demo,
+// built by both versions for several counts : one, a few, and more than two ranges of instanceGrain.
+static bool compareInstanceBuilds()
+{
+    const unsigned int counts[5] = {1, 3, 6, instanceGrain + 1, 2 * instanceGrain + 3};
+    unsigned int bodyCount = 3 * instanceGrain;
+
+    RandomStream random;
+    initRandomStream(random, testSeed, 0);
+    BodyStore bodies;
+    initBodyStore(bodies, bodyCount);
+    fillRandomFloats(random, bodies.posX, bodyCount, -50.0f, 50.0f);
+    fillRandomFloats(random, bodies.posY, bodyCount, -50.0f, 50.0f);
+    fillRandomFloats(random, bodies.posZ, bodyCount, -50.0f, 50.0f);
+    std::vector<unsigned int> order(bodyCount);
+    for (unsigned int i = 0; i < bodyCount; i++)
+    {
+        glm::quat orientation(nextRandomFloat(random, -1.0f, 1.0f), nextRandomFloat(random, -1.0f, 1.0f),
+                              nextRandomFloat(random, -1.0f, 1.0f), nextRandomFloat(random, -1.0f, 1.0f));
+        setBodyOrientation(bodies, i, glm::normalize(orientation));
+        order[i] = i;
+    }
+    for (unsigned int i = bodyCount - 1; i > 0; i--)
+    {
+        std::swap(order[i], order[nextRandom(random) % (i + 1)]);
+    }
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(60.0f, 40.0f, 30.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::mat4 viewProjection = projection * view;
+
+    TaskPool pool;
+    startTaskPool(pool, 0);
+    unsigned int total = 0, mismatches = 0;
+    for (int c = 0; c < 5; c++)
+    {
+        unsigned int count = counts[c];
+        total += count;
+        std::vector<InstanceData> expected(count), built(count);
+        buildInstances_slow(bodies, &order[0], count, viewProjection, 2.5f, &expected[0]);
+        buildInstances(pool, bodies, &order[0], count, viewProjection, 2.5f, &built[0]);
+        for (unsigned int s = 0; s < count; s++)
+        {
+            if (!sameValues(&expected[s].mvp[0][0], &built[s].mvp[0][0], 16) ||
+                !sameValues(&expected[s].model[0][0], &built[s].model[0][0], 16) ||
+                !sameValues(&expected[s].light[0], &built[s].light[0], 4))
+            {
+                if (mismatches++ < 5)
+                {
+                    printf("%u instances : instance %u of object %u differs\n", count, s, order[s]);
+                }
+            }
+        }
+    }
+    stopTaskPool(pool);
+
+    printf("buildInstances : %u instances, %s\n", total, mismatches == 0 ? "same" : "DIFFERENT");
+    return mismatches == 0;
+}
+
+int main(void)
+{
+    if (!compareInstanceBuilds())
+    {
+        fprintf(stderr, "buildInstances and buildInstances_slow differ\n");
+        return 1;
+    }
+
+    if (!glfwInit())
+    {
+        printf("Skipped : failed to initialize GLFW, is there a display ?\n");
+        return testSkipped;
+    }
+
+    // The window is never shown, the pictures are drawn into a framebuffer object.
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    GLFWwindow * window = glfwCreateWindow(testWidth, testHeight, "Instancing test", NULL, NULL);
+    if (window == NULL)
+    {
+        printf("Skipped : failed to open a GLFW window with a 2.1 context\n");
+        glfwTerminate();
+        return testSkipped;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (glewInit() != GLEW_OK)
+    {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        return 1;
+    }
+
+    if (!isInstancingSupported() || !GLEW_ARB_framebuffer_object)
+    {
+        printf("Skipped : the context has no instancing or no framebuffer objects\n");
+        glfwTerminate();
+        return testSkipped;
+    }
+
+    TestProgram perObject, instanced;
+    if (!loadTestProgram(perObject, "StandardShading.vertexshader") ||
+        !loadTestProgram(instanced, "StandardShadingInstanced.vertexshader"))
+    {
+        fprintf(stderr, "Failed to load the shaders\n");
+        glfwTerminate();
+        return 1;
+    }
+    GLint matrixID = glGetUniformLocation(perObject.program, "MVP");
+    GLint modelMatrixID = glGetUniformLocation(perObject.program, "M");
+    GLint light2ID = glGetUniformLocation(perObject.program, "LightPosition_worldspace2");
+    GLint lightPower2ID = glGetUniformLocation(perObject.program, "LightPower2");
+    InstanceAttributes instanceAttributes;
+    getInstanceAttributes(instanced.program, instanceAttributes);
+
+    // The mesh of the demo, without its cache or its levels of detail.
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    if (!loadOBJ("suzanne.obj", vertices, uvs, normals))
+    {
+        fprintf(stderr, "Failed to load suzanne.obj\n");
+        glfwTerminate();
+        return 1;
+    }
+    std::vector<unsigned int> indices;
+    std::vector<InterleavedVertex> interleaved;
+    indexVBO_interleaved(vertices, uvs, normals, indices, interleaved);
+
+    GLuint vertexbuffer;
+    glGenBuffers(1, &vertexbuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
+    glBufferData(GL_ARRAY_BUFFER, interleaved.size() * sizeof(InterleavedVertex), &interleaved[0], GL_STATIC_DRAW);
+    GLuint elementbuffer;
+    glGenBuffers(1, &elementbuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    GLuint instancebuffer;
+    glGenBuffers(1, &instancebuffer);
+    GLuint texture = loadBMP_custom("spooky.bmp");
+
+    // The picture is drawn into this framebuffer, with a depth buffer like the window of the demo.
+    GLuint framebuffer, colorbuffer, depthbuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(1, &colorbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, testWidth, testHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorbuffer);
+    glGenRenderbuffers(1, &depthbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, testWidth, testHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        printf("Skipped : the framebuffer object is not complete\n");
+        glfwTerminate();
+        return testSkipped;
+    }
+    glViewport(0, 0, testWidth, testHeight);
+    glClearColor(0.0f, 0.0f, 0.4f, 0.0f);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+
+    // A few objects in front of the camera, turned different ways, some overlapping.
+    BodyStore bodies;
+    initBodyStore(bodies, 7);
+    for (int i = 0; i < bodies.count; i++)
+    {
+        bodies.posX[i] = (i % 4) * 2.5f - 3.75f;
+        bodies.posY[i] = (i / 4) * 2.5f - 1.25f;
+        bodies.posZ[i] = -0.5f * i;
+        setBodyOrientation(bodies, i, glm::angleAxis(0.7f * i, glm::normalize(glm::vec3(1.0f, 2.0f, 0.5f * i))));
+    }
+    std::vector<unsigned int> order(bodies.count);
+    for (int i = 0; i < bodies.count; i++)
+    {
+        order[i] = i;
+    }
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)testWidth / testHeight, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 12.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+
+    TaskPool pool;
+    startTaskPool(pool, 0);
+    std::vector<InstanceData> instances(bodies.count);
+    buildInstances(pool, bodies, &order[0], bodies.count, viewProjection, 1.0f, &instances[0]);
+    stopTaskPool(pool);
+
+    GLStateCache glState;
+    initGLStateCache(glState);
+
+    // The objects one by one, like the demo without instancing.
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    beginTestDraw(glState, perObject, view, texture, vertexbuffer, elementbuffer);
+    for (unsigned int v = 0; v < instances.size(); v++)
+    {
+        const InstanceData & instance = instances[v];
+        cachedUniformMatrix4fv(glState, matrixID, &instance.mvp[0][0]);
+        cachedUniformMatrix4fv(glState, modelMatrixID, &instance.model[0][0]);
+        cachedUniform3f(glState, light2ID, instance.light.x, instance.light.y, instance.light.z);
+        cachedUniform1f(glState, lightPower2ID, instance.light.w);
+        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, (void*)0);
+    }
+    endTestDraw(glState, perObject);
+    std::vector<unsigned char> perObjectPixels;
+    readPicture(perObjectPixels);
+
+    // The same objects with one instanced call.
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    uploadInstances(glState, instancebuffer, instances);
+    beginTestDraw(glState, instanced, view, texture, vertexbuffer, elementbuffer);
+    bindInstanceAttributes(glState, instancebuffer, instanceAttributes, 0);
+    glDrawElementsInstancedARB(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, (void*)0, instances.size());
+    unbindInstanceAttributes(glState, instanceAttributes);
+    endTestDraw(glState, instanced);
+    std::vector<unsigned char> instancedPixels;
+    readPicture(instancedPixels);
+
+    GLenum error = glGetError();
+
+    // Compare them, and make sure the objects were drawn at all.
+    const unsigned char background[4] = {0, 0, 102, 0};
+    unsigned int mismatches = 0;
+    unsigned int covered = 0;
+    for (unsigned int p = 0; p < perObjectPixels.size(); p += 4)
+    {
+        if (!samePixel(&perObjectPixels[p], &instancedPixels[p]))
+        {
+            mismatches++;
+        }
+        if (!samePixel(&perObjectPixels[p], background))
+        {
+            covered++;
+        }
+    }
+    unsigned int pixelCount = testWidth * testHeight;
+    printf("%u of %u pixels covered by the objects, %u differ\n", covered, pixelCount, mismatches);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &colorbuffer);
+    glDeleteRenderbuffers(1, &depthbuffer);
+    glDeleteBuffers(1, &vertexbuffer);
+    glDeleteBuffers(1, &elementbuffer);
+    glDeleteBuffers(1, &instancebuffer);
+    glDeleteProgram(perObject.program);
+    glDeleteProgram(instanced.program);
+    glDeleteTextures(1, &texture);
+    glfwTerminate();
+
+    if (error != GL_NO_ERROR)
+    {
+        fprintf(stderr, "GL error 0x%x\n", error);
+        return 1;
+    }
+    if (covered < pixelCount / 20)
+    {
+        fprintf(stderr, "The objects were not drawn\n");
+        return 1;
+    }
+    if (mismatches > pixelCount * maxMismatchFraction)
+    {
+        fprintf(stderr, "The instanced and the per-object pictures differ\n");
+        return 1;
+    }
+    printf("The instanced and the per-object pictures match\n");
+    return 0;
+}
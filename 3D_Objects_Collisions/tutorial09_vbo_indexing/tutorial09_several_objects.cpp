@@ -1,800 +1,906 @@
-/*
-Last Date Modified: 1/9/2024
-
-Description:
-
-The objects are frozen in place until the user presses the “g” key and then 
-objects start moving around at random speeds and rotating randomly. 
-The objects’ movements are calculated in a thread. 
-The objects are able to collide and bounce off each other. 
-The objects are also confined to the space around the center of the scene.
-
-*/
-
-// Include standard headers
-#include <stdio.h>
-#include <stdlib.h>
-#include <vector>
-#include <thread>
-#include <cstdlib>
-#include <random>
-#include <functional>
-
-
-// Include GLEW
-#include <GL/glew.h>
-
-// Include GLFW
-#include <glfw3.h>
-GLFWwindow* window;
-
-// Include GLM
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-using namespace glm;
-
-#include <common/shader.hpp>
-#include <common/texture.hpp>
-#include <common/controls.hpp>
-#include <common/objloader.hpp>
-#include <common/vboindexer.hpp>
-
-// Define the boundary of the object's movement.
-#define xPositiveWall    14
-#define xNegativeWall   -14
-#define yPositiveWall    14
-#define yNegativeWall   -14
-#define zPositiveWall    15
-#define zNegativeWall    3
-
-extern int moveControl;
-
-// Define the attributes of the object.
-typedef struct item
-{
-    double objXPos;
-    double objYPos;
-    double objZPos;
-    double objXSpeed;
-    double objYSpeed;
-    double objZSpeed;
-    float objXRot;
-    float objYRot;
-    float objZRot;
-    float objXRotSpeed;
-    float objYRotSpeed;
-    float objZRotSpeed;
-}Item;
-
-// Calculate the position and rotation of objects.
-void kinematicTrajectory(Item * obj, int move)
-{
-    double distance1, distance2, distance3, distance4, distance5, distance6;
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-
-    // If the user presses the g-key (move = 0), all objects will stop moving and rotating.
-    if (move == 0)
-    {
-        for (int i = 0; i < 4; i++)
-        {
-            obj[i].objXPos = obj[i].objXPos;
-            obj[i].objYPos = obj[i].objYPos;
-            obj[i].objZPos = obj[i].objZPos;
-            obj[i].objXRot = obj[i].objXRot;
-            obj[i].objYRot = obj[i].objYRot;
-            obj[i].objZRot = obj[i].objZRot;
-        }    
-    }
-    else
-    {
-        // 6 if-statements to handle the collision between objects.
-        // Calculate the distance between two objects, if it is smaller than the threshold, the direction of the velocity of objects will change.
-        distance1 = sqrt(pow(obj[0].objXPos - obj[1].objXPos, 2) + pow(obj[0].objYPos - obj[1].objYPos, 2) + pow(obj[0].objZPos - obj[1].objZPos, 2));
-        distance2 = sqrt(pow(obj[0].objXPos - obj[2].objXPos, 2) + pow(obj[0].objYPos - obj[2].objYPos, 2) + pow(obj[0].objZPos - obj[2].objZPos, 2));
-        distance3 = sqrt(pow(obj[0].objXPos - obj[3].objXPos, 2) + pow(obj[0].objYPos - obj[3].objYPos, 2) + pow(obj[0].objZPos - obj[3].objZPos, 2));
-        distance4 = sqrt(pow(obj[1].objXPos - obj[2].objXPos, 2) + pow(obj[1].objYPos - obj[2].objYPos, 2) + pow(obj[1].objZPos - obj[2].objZPos, 2));
-        distance5 = sqrt(pow(obj[1].objXPos - obj[3].objXPos, 2) + pow(obj[1].objYPos - obj[3].objYPos, 2) + pow(obj[1].objZPos - obj[3].objZPos, 2));
-        distance6 = sqrt(pow(obj[2].objXPos - obj[3].objXPos, 2) + pow(obj[2].objYPos - obj[3].objYPos, 2) + pow(obj[2].objZPos - obj[3].objZPos, 2));
-        
-        // There are 6 if-statements to handle the object collision. After the collision, the direction will change and the speed is random.
-        if (distance1 < 4.0) 
-        {
-            obj[0].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[0].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[0].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-
-            obj[1].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[1].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[1].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-        }
-
-        if (distance2 < 4.0) 
-        {
-            obj[0].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[0].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[0].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-            
-            obj[2].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[2].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[2].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-        }
-
-        if (distance3 < 4.0) 
-        {
-            obj[0].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[0].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[0].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-
-            obj[3].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[3].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[3].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-        }
-
-        if (distance4 < 4.0) 
-        {
-            obj[1].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[1].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[1].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-
-            obj[2].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[2].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[2].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-        }
-
-        if (distance5 < 4.0) 
-        {
-
-            obj[1].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[1].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[1].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-
-            obj[3].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[3].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[3].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);      
-        }
-
-        if (distance6 < 4.0) 
-        {
-            obj[2].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[2].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[2].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-
-            obj[3].objXSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 1);
-            obj[3].objYSpeed = (-1) * (2 * (((double)rand()) / RAND_MAX) - 0.5);
-            obj[3].objZSpeed = (-1) * ((((double)rand()) / RAND_MAX) + 1);
-        }
-
-        // Update the position of all objects and handle the collision to wall.
-        for (int i = 0; i < 4; i++)
-        {
-            // If the object is colliding with the wall at x-direction, the direction of speed will changed.
-            if ((obj[i].objXPos <= xNegativeWall) || (obj[i].objXPos >= xPositiveWall))
-            {   
-                // If the collision happens, the x-direction of object's rotation will change.
-                obj[i].objXRotSpeed = 0;
-                obj[i].objYRotSpeed = (((double)rand()) / RAND_MAX) + 3;
-                obj[i].objZRotSpeed = 0;
-
-                // If the object is colliding with the x-direction wall, it will set the position at the boundary 
-                // and change the direction of the speed.
-                if (obj[i].objXPos < xNegativeWall)
-                {
-                    obj[i].objXPos = xNegativeWall;
-                    if (obj[i].objXSpeed < 0)
-                    {
-                        obj[i].objXSpeed = (-1) * obj[i].objXSpeed;
-                    }
-                    
-                }
-                else if (obj[i].objXPos >= xPositiveWall)
-                {
-                    obj[i].objXPos = xPositiveWall;
-                    if (obj[i].objXSpeed > 0)
-                    {
-                        obj[i].objXSpeed = (-1) * obj[i].objXSpeed;
-                    }
-                }
-            }
-
-            // If the object is colliding with the wall at y-direction, the direction of speed will changed.
-            if ((obj[i].objYPos <= yNegativeWall) || (obj[i].objYPos >= yPositiveWall))
-            {
-                // If the collision happens, the y-direction of object's rotation will change.
-                obj[i].objXRotSpeed = 0;
-                obj[i].objYRotSpeed = 0;
-                obj[i].objZRotSpeed = (((double)rand()) / RAND_MAX) + 3;
-
-                // If the object is colliding with the y-direction wall, it will set the position at the boundary 
-                // and change the direction of the speed.
-                if (obj[i].objYPos < yNegativeWall)
-                {
-                    obj[i].objYPos = yNegativeWall;
-                    if (obj[i].objYSpeed < 0)
-                    {
-                        obj[i].objYSpeed = (-1) * obj[i].objYSpeed;
-                    }
-                    
-                }
-                else if (obj[i].objYPos >= yPositiveWall)
-                {
-                    obj[i].objYPos = yPositiveWall;
-                    if (obj[i].objYSpeed > 0)
-                    {
-                        obj[i].objYSpeed = (-1) * obj[i].objYSpeed;
-                    }
-                }
-            }
-
-            // If the object is colliding with the wall at z-direction, the direction of speed will changed.
-            if ((obj[i].objZPos < zNegativeWall) || (obj[i].objZPos >= zPositiveWall))
-            {
-                // If the collision happens, the z-direction of object's rotation will change.
-                obj[i].objXRotSpeed = (((double)rand()) / RAND_MAX) + 3;
-                obj[i].objYRotSpeed = 0;
-                obj[i].objZRotSpeed = 0;
-
-                // If the object is colliding with the z-direction wall, it will set the position at the boundary 
-                // and change the direction of the speed.
-                if (obj[i].objZPos < zNegativeWall)
-                {
-                    obj[i].objZPos = zNegativeWall;
-                    if (obj[i].objZSpeed < 0)
-                    {
-                        obj[i].objZSpeed = (-1) * obj[i].objZSpeed;
-                    }
-                    
-                }
-                else if (obj[i].objZPos >= zPositiveWall)
-                {
-                    obj[i].objZPos = zPositiveWall;
-                    if (obj[i].objZSpeed > 0)
-                    {
-                        obj[i].objZSpeed = (-1) * obj[i].objZSpeed;
-                    }
-                }
-            }
-
-
-            // Update the rotation and handle the collision to the wall.
-            obj[i].objXRot = obj[i].objXRot + obj[i].objXRotSpeed;
-            obj[i].objYRot = obj[i].objYRot + obj[i].objYRotSpeed;
-            obj[i].objZRot = obj[i].objZRot + obj[i].objZRotSpeed;
-
-            // If the angle of the rotation is larger than 360 or smaller than 0,
-            // the following if-else if statement will deal with it.
-            if (obj[i].objXRot >= 360)
-            {
-                obj[i].objXRot = obj[i].objXRot - 360;
-            }
-            else if (obj[i].objXRot <= 0)
-            {
-                obj[i].objXRot = obj[i].objXRot + 360;
-            }
-
-            if (obj[i].objYRot >= 360)
-            {
-                obj[i].objYRot = obj[i].objYRot - 360;
-            }
-            else if (obj[i].objYRot <= 0)
-            {
-                obj[i].objYRot = obj[i].objYRot + 360;
-            }
-
-            if (obj[i].objZRot >= 360)
-            {
-                obj[i].objZRot = obj[i].objZRot - 360;
-            }
-            else if (obj[i].objZRot <= 0)
-            {
-                obj[i].objZRot = obj[i].objZRot + 360;
-            }
-
-            // Update the position of objects.
-            obj[i].objXPos = obj[i].objXPos + (obj[i].objXSpeed * 0.05);
-            obj[i].objYPos = obj[i].objYPos + (obj[i].objYSpeed * 0.02);
-            obj[i].objZPos = obj[i].objZPos + (obj[i].objZSpeed * 0.1);
-        }
-    }
-}
-
-// This function is to change the internal light of the object randomly.
-float randomLightIntensity()
-{
-    float intensity;
-    std::srand(time(nullptr));
-
-    intensity = rand() % 3;
-
-    return intensity;
-}
-
-
-int main(void)
-{
-    float lightIntensity = 1;
-    int counter = 2;
-
-    // Initialise GLFW
-    if(!glfwInit())
-    {
-        fprintf(stderr, "Failed to initialize GLFW\n");
-        getchar();
-        return -1;
-    }
-
-    glfwWindowHint(GLFW_SAMPLES, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
-
-    // Open a window and create its OpenGL context
-    window = glfwCreateWindow( 1920, 1080, "Final Project - 4 Objects Random Movement", NULL, NULL);
-    if(window == NULL)
-    {
-        fprintf(stderr, "Failed to open GLFW window.\n");
-        getchar();
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    
-    // Initialize GLEW
-    if (glewInit() != GLEW_OK) 
-    {
-        fprintf(stderr, "Failed to initialize GLEW\n");
-        getchar();
-        glfwTerminate();
-        return -1;
-    }
-
-    // Ensure we can capture the escape key being pressed below
-    glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
-    // Hide the mouse and enable unlimited movement
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    
-    // Set the mouse at the center of the screen
-    glfwPollEvents();
-    glfwSetCursorPos(window, 1024/2, 768/2);
-
-    // Black background
-    glClearColor(0.0f, 0.0f, 0.4f, 0.0f);
-
-    // Enable depth test
-    glEnable(GL_DEPTH_TEST);
-    // Accept fragment if it closer to the camera than the former one
-    glDepthFunc(GL_LESS); 
-
-    // Cull triangles which normal is not towards the camera
-    //glEnable(GL_CULL_FACE);
-    glEnable(GL_LIGHTING);
-
-    // Create and compile our GLSL program from the shaders
-    GLuint programID = LoadShaders("StandardShading.vertexshader", "StandardShading.fragmentshader");
-
-    // Get a handle for our "MVP" uniform
-    GLuint MatrixID = glGetUniformLocation(programID, "MVP");
-    GLuint ViewMatrixID = glGetUniformLocation(programID, "V");
-    GLuint ModelMatrixID = glGetUniformLocation(programID, "M");
-
-    // Get a handle for our "JustGreen" and "LightComponent" uniform to control the light on the objects and the color of the xy-plane.
-    GLuint JustGreen = glGetUniformLocation(programID, "JustGreen");
-    GLuint LightComponent = glGetUniformLocation(programID, "LightComponent");
-    //GLuint LightPower = glGetUniformLocation(programID, "LightPower");
-    GLuint LightPower2 = glGetUniformLocation(programID, "LightPower2");
-    glUseProgram(programID);
-
-    // Get a handle for our buffers
-    GLuint vertexPosition_modelspaceID = glGetAttribLocation(programID, "vertexPosition_modelspace");
-    GLuint vertexUVID = glGetAttribLocation(programID, "vertexUV");
-    GLuint vertexNormal_modelspaceID = glGetAttribLocation(programID, "vertexNormal_modelspace");
-
-    // Load the texture for the object.
-    GLuint Texture = loadDDS("uvmap.DDS");
-
-    // Load the texture for the floor.
-    GLuint Texture2 = loadBMP_custom("spooky.bmp");
-    
-    // Get a handle for our "myTextureSampler" uniform
-    GLuint TextureID  = glGetUniformLocation(programID, "myTextureSampler");
-
-    // Read our .obj file
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> uvs;
-    std::vector<glm::vec3> normals;
-    bool res = loadOBJ("suzanne.obj", vertices, uvs, normals);
-
-    std::vector<unsigned short> indices;
-    std::vector<glm::vec3> indexed_vertices;
-    std::vector<glm::vec2> indexed_uvs;
-    std::vector<glm::vec3> indexed_normals;
-    indexVBO(vertices, uvs, normals, indices, indexed_vertices, indexed_uvs, indexed_normals);
-
-    // Load it into a VBO
-
-    GLuint vertexbuffer;
-    glGenBuffers(1, &vertexbuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-    glBufferData(GL_ARRAY_BUFFER, indexed_vertices.size() * sizeof(glm::vec3), &indexed_vertices[0], GL_STATIC_DRAW);
-
-    GLuint uvbuffer;
-    glGenBuffers(1, &uvbuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-    glBufferData(GL_ARRAY_BUFFER, indexed_uvs.size() * sizeof(glm::vec2), &indexed_uvs[0], GL_STATIC_DRAW);
-
-    GLuint normalbuffer;
-    glGenBuffers(1, &normalbuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-    glBufferData(GL_ARRAY_BUFFER, indexed_normals.size() * sizeof(glm::vec3), &indexed_normals[0], GL_STATIC_DRAW);
-
-    // Generate a buffer for the indices as well
-    GLuint elementbuffer;
-    glGenBuffers(1, &elementbuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0] , GL_STATIC_DRAW);
-
-    // The coordinates for the textured image.
-    static const GLfloat g_vertex_buffer_data[] = 
-    {
-        15.0f, -15.0f, 0.0f,  
-        -15.0f, -15.0f, 0.0f, 
-        -15.0f, 15.0f, 0.0f,  
-        15.0f, -15.0f, 0.0f,  
-        15.0f, 15.0f, 0.0f,   
-        -15.0f, 15.0f, 0.0f,  
-    };
-
-    // The UV coordinates for the textured image.
-    static const GLfloat g_uv_buffer_data[] = 
-    {
-        1.0f, 0.0f,	
-        0.0f, 0.0f,  	
-   	    0.0f, 1.0f,
-        1.0f, 0.0f,
-        1.0f, 1.0f,
-        0.0f, 1.0f
-    };
-
-    // Generate and store the coordinates for the floor with a textured image.
-    GLuint vertexbuffer2;
-    glGenBuffers(1, &vertexbuffer2);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer2);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data), g_vertex_buffer_data, GL_STATIC_DRAW);
-
-    // Generate and store the UV coordinates for the floor with a textured image.
-    GLuint uvbuffer2;
-	glGenBuffers(1, &uvbuffer2);
-	glBindBuffer(GL_ARRAY_BUFFER, uvbuffer2);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_uv_buffer_data), g_uv_buffer_data, GL_STATIC_DRAW);
-
-
-    // Get a handle for our "LightPosition" uniform
-    glUseProgram(programID);
-    GLuint LightID = glGetUniformLocation(programID, "LightPosition_worldspace");
-    GLuint LightID2 = glGetUniformLocation(programID, "LightPosition_worldspace2");
-
-    // Initialize 4 objects initial positions, rotations, and their random speed.
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-    Item obj[4];   
-    obj[0].objXPos = 4;
-    obj[0].objYPos = 0.0;
-    obj[0].objZPos = 3;
-    obj[0].objXRot = 90;
-    obj[0].objYRot = 90;
-    obj[0].objZRot = 0;
-    obj[1].objXPos = -4;
-    obj[1].objYPos = 0.0;
-    obj[1].objZPos = 3;
-    obj[1].objXRot = 90;
-    obj[1].objYRot = -90;
-    obj[1].objZRot = 0;
-    obj[2].objXPos = 0.0;
-    obj[2].objYPos = 4;
-    obj[2].objZPos = 3;
-    obj[2].objXRot = 90;
-    obj[2].objYRot = 180;
-    obj[2].objZRot = 0;
-    obj[3].objXPos = 0.0;
-    obj[3].objYPos = -4;
-    obj[3].objZPos = 3;
-    obj[3].objXRot = 90;
-    obj[3].objYRot = 0;
-    obj[3].objZRot = 0;
-
-
-    for (int i = 0; i < 4; ++i) 
-    {
-        obj[i].objXSpeed = 2 * (((double)rand()) / RAND_MAX) - 1;
-        obj[i].objYSpeed = 2 * (((double)rand()) / RAND_MAX) - 1;
-        obj[i].objZSpeed = (((double)rand()) / RAND_MAX) + 1;
-        obj[i].objXRotSpeed = 0;
-        obj[i].objYRotSpeed = 0;
-        obj[i].objZRotSpeed = (((double)rand()) / RAND_MAX) + 1;
-    }
-
-    do
-    {
-        // This statement is used to change the light intensity randomly but make sure that 
-        // the frequency of change is not too fast.
-        if (moveControl != 0)
-        {
-            counter--;
-            if (counter == 0)
-            {
-                lightIntensity = randomLightIntensity();
-                counter = 2;
-            }
-        }
-
-        // The calculation of the kinematics of objects is conducted by the thread.
-        std::thread wk(kinematicTrajectory, obj, moveControl);
-        wk.join();
-
-        // Clear the screen
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-
-        // Compute the MVP matrix from keyboard and mouse input
-        computeMatricesFromInputs();
-        
-        glm::mat4 ProjectionMatrix = getProjectionMatrix();
-        glm::mat4 ViewMatrix = getViewMatrix();
-        glUseProgram(programID);
-
-        ////// Start of the rendering of the first object //////
-        
-        glm::vec3 lightPos = glm::vec3(0,0,25);
-        glUniform3f(LightID, lightPos.x, lightPos.y, lightPos.z);
-
-        // Change the internal light's intensity randomly for the object.
-        glUniform3f(LightID2, obj[0].objXPos, obj[0].objYPos, obj[0].objZPos);
-        glUniform1f(LightPower2, lightIntensity);
-
-        glUniformMatrix4fv(ViewMatrixID, 1, GL_FALSE, &ViewMatrix[0][0]); // This one doesn't change between objects, so this can be done once for all objects that use "programID"
-        
-        // Set the kinetic matrix of the object.
-        glm::mat4 ModelMatrix1 = glm::mat4(1.0);
-        ModelMatrix1 = glm::translate(ModelMatrix1, glm::vec3(obj[0].objXPos, obj[0].objYPos, obj[0].objZPos));
-        ModelMatrix1 = glm::rotate(ModelMatrix1, glm::radians(obj[0].objXRot), glm::vec3(1.0f, 0.0f, 0.0f));
-        ModelMatrix1 = glm::rotate(ModelMatrix1, glm::radians(obj[0].objYRot), glm::vec3(0.0f, 1.0f, 0.0f));
-        ModelMatrix1 = glm::rotate(ModelMatrix1, glm::radians(obj[0].objZRot), glm::vec3(0.0f, 0.0f, 1.0f));
-        glm::mat4 MVP1 = ProjectionMatrix * ViewMatrix * ModelMatrix1;
-        
-
-        // Send our transformation to the currently bound shader, in the "MVP1" uniform
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP1[0][0]);
-        glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix1[0][0]);
-
-        // Bind our texture in Texture Unit 0
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, Texture);
-        // Set our "myTextureSampler" sampler to user Texture Unit 0
-        glUniform1i(TextureID, 0);
-
-        // 1rst attribute buffer : vertices
-        glEnableVertexAttribArray(vertexPosition_modelspaceID);
-        glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-        glVertexAttribPointer
-        (
-            vertexPosition_modelspaceID, // The attribute we want to configure
-            3,                  // size
-            GL_FLOAT,           // type
-            GL_FALSE,           // normalized?
-            0,                  // stride
-            (void*)0            // array buffer offset
-        );
-
-        // 2nd attribute buffer : UVs
-        glEnableVertexAttribArray(vertexUVID);
-        glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-        glVertexAttribPointer
-        (
-            vertexUVID,                       // The attribute we want to configure
-            2,                                // size : U+V => 2
-            GL_FLOAT,                         // type
-            GL_FALSE,                         // normalized?
-            0,                                // stride
-            (void*)0                          // array buffer offset
-        );
-
-        // 3rd attribute buffer : normals
-        glEnableVertexAttribArray(vertexNormal_modelspaceID);
-        glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-        glVertexAttribPointer
-        (
-            vertexNormal_modelspaceID,        // The attribute we want to configure
-            3,                                // size
-            GL_FLOAT,                         // type
-            GL_FALSE,                         // normalized?
-            0,                                // stride
-            (void*)0                          // array buffer offset
-        );
-
-        // Index buffer
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-
-        // Draw the triangles !
-        glUniform1i(JustGreen, 0);
-        glDrawElements
-        (
-            GL_TRIANGLES,      // mode
-            indices.size(),    // count
-            GL_UNSIGNED_SHORT,   // type
-            (void*)0           // element array buffer offset
-        );
-
-        ////// End of rendering of the first object //////
-
-        ////// Start of the rendering of the second object //////
-
-        // Set the kinetic matrix of the object.
-        glm::mat4 ModelMatrix2 = glm::mat4(1.0);
-        ModelMatrix2 = glm::translate(ModelMatrix2, glm::vec3(obj[1].objXPos, obj[1].objYPos, obj[1].objZPos));
-        ModelMatrix2 = glm::rotate(ModelMatrix2, glm::radians(obj[1].objXRot), glm::vec3(1.0f, 0.0f, 0.0f));
-        ModelMatrix2 = glm::rotate(ModelMatrix2, glm::radians(obj[1].objYRot), glm::vec3(0.0f, 1.0f, 0.0f));
-        ModelMatrix2 = glm::rotate(ModelMatrix2, glm::radians(obj[1].objZRot), glm::vec3(0.0f, 0.0f, 1.0f));
-        glm::mat4 MVP2 = ProjectionMatrix * ViewMatrix * ModelMatrix2;
-
-
-        // Send our transformation to the currently bound shader in the "MVP2" uniform
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP2[0][0]);
-        glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix2[0][0]);
-
-        // Change the internal light's intensity randomly for the object.
-        glUniform3f(LightID2, obj[1].objXPos, obj[1].objYPos, obj[1].objZPos);
-        glUniform1f(LightPower2, lightIntensity);
-
-        // The rest is exactly the same as the first object
-        
-        // 1rst attribute buffer : vertices
-        glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-        glVertexAttribPointer(vertexPosition_modelspaceID, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // 2nd attribute buffer : UVs
-        glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-        glVertexAttribPointer(vertexUVID, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // 3rd attribute buffer : normals
-        glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-        glVertexAttribPointer(vertexNormal_modelspaceID, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // Index buffer
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-       
-
-        // Draw the triangles !
-        glUniform1i(JustGreen, 0);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_SHORT, (void*)0);
-
-        ////// End of rendering of the second object //////
-
-        ////// Start of the rendering of the third object //////
-
-        // Set the kinetic matrix of the object.
-        glm::mat4 ModelMatrix3 = glm::mat4(1.0);
-        ModelMatrix3 = glm::translate(ModelMatrix3, glm::vec3(obj[2].objXPos, obj[2].objYPos, obj[2].objZPos));
-        ModelMatrix3 = glm::rotate(ModelMatrix3, glm::radians(obj[2].objXRot), glm::vec3(1.0f, 0.0f, 0.0f));
-        ModelMatrix3 = glm::rotate(ModelMatrix3, glm::radians(obj[2].objYRot), glm::vec3(0.0f, 1.0f, 0.0f));
-        ModelMatrix3 = glm::rotate(ModelMatrix3, glm::radians(obj[2].objZRot), glm::vec3(0.0f, 0.0f, 1.0f));
-        glm::mat4 MVP3 = ProjectionMatrix * ViewMatrix * ModelMatrix3;
-
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP3[0][0]);
-        glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix3[0][0]);
-
-        // Change the internal light's intensity randomly for the object.
-        glUniform3f(LightID2, obj[2].objXPos, obj[2].objYPos, obj[2].objZPos);
-        glUniform1f(LightPower2, lightIntensity);
-        
-        // 1rst attribute buffer : vertices
-        glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-        glVertexAttribPointer(vertexPosition_modelspaceID, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // 2nd attribute buffer : UVs
-        glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-        glVertexAttribPointer(vertexUVID, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // 3rd attribute buffer : normals
-        glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-        glVertexAttribPointer(vertexNormal_modelspaceID, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // Index buffer
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-
-        // Draw the triangles !
-        glUniform1i(JustGreen, 0);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_SHORT, (void*)0);
-
-        ////// End of rendering of the third object //////
-
-        ////// Start of the rendering of the forth object //////
-
-        // Set the kinetic matrix of the object.
-        glm::mat4 ModelMatrix4 = glm::mat4(1.0);
-        ModelMatrix4 = glm::translate(ModelMatrix4, glm::vec3(obj[3].objXPos, obj[3].objYPos, obj[3].objZPos));
-        ModelMatrix4 = glm::rotate(ModelMatrix4, glm::radians(obj[3].objXRot), glm::vec3(1.0f, 0.0f, 0.0f));
-        ModelMatrix4 = glm::rotate(ModelMatrix4, glm::radians(obj[3].objYRot), glm::vec3(0.0f, 1.0f, 0.0f));
-        ModelMatrix4 = glm::rotate(ModelMatrix4, glm::radians(obj[3].objZRot), glm::vec3(0.0f, 0.0f, 1.0f));
-        glm::mat4 MVP4 = ProjectionMatrix * ViewMatrix * ModelMatrix4;
-
-
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP4[0][0]);
-        glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix4[0][0]);
-
-        // Change the internal light's intensity randomly for the object.
-        glUniform3f(LightID2, obj[3].objXPos, obj[3].objYPos, obj[3].objZPos);
-        glUniform1f(LightPower2, lightIntensity);
-        
-        // 1rst attribute buffer : vertices
-        glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-        glVertexAttribPointer(vertexPosition_modelspaceID, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // 2nd attribute buffer : UVs
-        glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-        glVertexAttribPointer(vertexUVID, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // 3rd attribute buffer : normals
-        glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-        glVertexAttribPointer(vertexNormal_modelspaceID, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // Index buffer
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-       
-
-        // Draw the triangles !
-        glUniform1i(JustGreen, 0);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_SHORT, (void*)0);
-
-        ////// End of rendering of the fourth object //////
-
-
-        ////// Start of the rendering of the textured floor //////
-
-        // Set the kinetic matrix of the floor.
-        glm::mat4 ModelMatrix = glm::mat4(1.0);
-        glm::mat4 MVP = ProjectionMatrix * ViewMatrix * ModelMatrix;
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-        glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-
-        // added Bind our texture in Texture Unit 1
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, Texture2);
-        // added Set our "myTextureSampler" sampler to user Texture Unit 0
-        glUniform1i(TextureID, 1);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer2);
-        glVertexAttribPointer(vertexPosition_modelspaceID, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // added 2nd attribute buffer : UVs
-        glBindBuffer(GL_ARRAY_BUFFER, uvbuffer2);
-        glVertexAttribPointer(vertexUVID, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-        // Draw the triangleS !
-        glUniform1i(JustGreen, 0);
-        glDrawArrays(GL_TRIANGLES, 0, 2*3);
-
-        ////// End of rendering of the xy-plane object //////
-
-        glDisableVertexAttribArray(vertexPosition_modelspaceID);
-        glDisableVertexAttribArray(vertexUVID);
-        glDisableVertexAttribArray(vertexNormal_modelspaceID);
-
-        // Swap buffers
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-
-    } // Check if the ESC key was pressed or the window was closed
-    while (glfwGetKey(window, GLFW_KEY_ESCAPE ) != GLFW_PRESS && glfwWindowShouldClose(window) == 0);
-
-    // Cleanup VBO and shader
-    glDeleteBuffers(1, &vertexbuffer);
-    glDeleteBuffers(1, &uvbuffer);
-    glDeleteBuffers(1, &normalbuffer);
-    glDeleteBuffers(1, &elementbuffer);
-    glDeleteBuffers(1, &vertexbuffer2);
-    glDeleteBuffers(1, &uvbuffer2);
-    glDeleteProgram(programID);
-    glDeleteTextures(1, &Texture);
-
-    // Close OpenGL window and terminate GLFW
-    glfwTerminate();
-
-    return 0;
-}
+/*
+Last Date Modified: 1/9/2024
+
+Description:
+
+The objects are frozen in place until the user presses the “g” key and then 
+objects start moving around at random speeds and rotating randomly. 
+The objects’ movements are calculated in a thread which runs alongside the rendering. 
+The objects are able to collide and bounce off each other. 
+The objects are also confined to the space around the center of the scene.
+
+*/
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <thread>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <random>
+#include <functional>
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+
+
+// Include GLEW
+#include <GL/glew.h>
+
+// Include GLFW
+#include <glfw3.h>
+GLFWwindow* window;
+
+// Include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+using namespace glm;
+
+#include <common/shader.hpp>
+#include <common/texture.hpp>
+#include <common/controls.hpp>
+#include <common/objloader.hpp>
+#include <common/mappedfile.hpp>
+#include <common/vboindexer.hpp>
+#include <common/vertexcache.hpp>
+#include <common/meshlod.hpp>
+#include <common/taskpool.hpp>
+#include <common/meshbvh.hpp>
+#include <common/meshcache.hpp>
+#include <common/frustum.hpp>
+#include <common/obb.hpp>
+#include <common/broadphase.hpp>
+#include <common/bodystore.hpp>
+#include <common/narrowphase.hpp>
+#include <common/ccd.hpp>
+#include <common/sleep.hpp>
+#include <common/physicsworker.hpp>
+#include <common/glstate.hpp>
+#include <common/instancing.hpp>
+#include <common/rng.hpp>
+#include <common/quaternion_utils.hpp>
+
+// Define the boundary of the object's movement.
+#define xPositiveWall    14
+#define xNegativeWall   -14
+#define yPositiveWall    14
+#define yNegativeWall   -14
+#define zPositiveWall    15
+#define zNegativeWall    3
+
+// Define the number of objects. They collide with the shape of the mesh, see CollisionShape.
+#define objCount         4
+
+// Every object has the same mass. Restitution is the part of the speed kept after hitting
+// another object or a wall : 1 bounces without losing any energy.
+#define bodyMass         1.0f
+#define bodyRestitution  1.0f
+
+// An object slower than sleepSpeed (units per step) for sleepSteps steps in a row, with all the objects
+// it touches, falls asleep : it is not simulated anymore until something hits it.
+#define sleepSpeed       0.002f
+#define sleepSteps       60
+
+// Every random number of a run comes from this seed, so the same seed replays the same run.
+#define simulationSeed   20240109u
+// Ids of the random streams : one per thread which draws numbers, and one for the initial state.
+#define physicsStream    0
+#define lightStream      1
+#define initialStream    2
+
+// Velocities are in units per step. The initial speeds along each axis are scaled by these.
+#define xSpeedScale      0.05f
+#define ySpeedScale      0.02f
+#define zSpeedScale      0.1f
+
+// The simulation advances by fixed steps, whatever the frame rate is.
+// One step moves the objects as much as one frame of a 60 Hz display used to.
+#define physicsTimeStep  (1.0 / 60.0)
+// If rendering falls further behind than this, the missing time is dropped instead of being caught up.
+#define maxSubsteps      5
+
+// Reorder the mesh for the vertex cache when it is loaded from the .obj file.
+// The reordered mesh is what gets cached, so delete suzanne.obj.meshcache after changing this.
+#define optimizeMeshForVertexCache true
+
+// A level of detail is used when its error covers at most this many pixels on the screen.
+#define lodPixelError    1.0f
+
+extern int moveControl;
+
+// The shape every object collides with, fitted to the mesh when it is loaded.
+struct CollisionShape
+{
+    OrientedBox box;    // The box of the mesh in model space.
+    MeshBvh bvh;        // The triangles of the mesh, tested after the box.
+    float radius;       // Bounding sphere around the model origin, tested before the box.
+    float coreRadius;   // Sphere around the model origin inside the box, swept during the step.
+};
+
+// Calculate the position and rotation of objects.
+void kinematicTrajectory(BodyStore * bodies, const CollisionShape * shape, SpatialGrid * grid, TaskPool * pool,
+                         RandomStream * random, SleepState * sleep, int move)
+{
+    std::vector<BodyPair> pairs;
+
+    // If the user presses the g-key (move = 0), all objects stop moving and rotating : there is nothing to calculate.
+    if (move != 0)
+    {
+        // The broad phase only reports the pairs of objects which are in the same or in neighbouring cells of the grid
+        // somewhere along this step's move, so the distance is not calculated for every pair of objects.
+        // Two sleeping objects can't collide, so their pairs are dropped.
+        float collisionDistance = 2.0f * shape->radius;
+        glm::vec3 wallMin(xNegativeWall, yNegativeWall, zNegativeWall);
+        glm::vec3 wallMax(xPositiveWall, yPositiveWall, zPositiveWall);
+        findSweptPairs(*grid, *bodies, collisionDistance, wallMin, wallMax, pairs);
+        removeSleepingPairs(*bodies, pairs);
+
+        // Two objects whose meshes touch bounce off each other : they get opposite impulses along the axis where
+        // their boxes overlap the least. The bounding spheres, then the boxes, then the BVHs of the meshes are tested,
+        // all turned with the objects. With many contacts the threads of the pool share them.
+        resolveMeshContactsParallel(*pool, *bodies, pairs, shape->box, shape->bvh, shape->radius, bodyRestitution);
+
+        // Move the objects. They bounce off the walls and off each other at the moment they hit them during the step,
+        // so fast objects can't pass through a wall or another object between two steps. The objects are swept
+        // as their core spheres : the boxes only touch at the start of a step, but the cores never pass through each other.
+        sweepBodies(*bodies, sleep->awake, pairs, 2.0f * shape->coreRadius, bodyRestitution, wallMin, wallMax);
+
+        // The objects at rest fall asleep, the ones which got hit wake up with everything they touch.
+        updateSleepStates(*sleep, *bodies, pairs, collisionDistance, sleepSpeed, sleepSteps);
+
+        // If the collision to a wall happens, the object starts to rotate about another axis.
+        // x-direction walls : rotation about y, y-direction walls : rotation about z, z-direction walls : rotation about x.
+        // Only awake objects can have touched a wall.
+        for (unsigned int a = 0; a < sleep->awake.size(); a++)
+        {
+            unsigned int i = sleep->awake[a];
+            int contact = bodies->wallContact[i];
+            if (contact & wallContactX)
+            {
+                bodies->rotSpeedX[i] = 0;
+                bodies->rotSpeedY[i] = glm::radians(nextRandomFloat(*random, 3.0f, 4.0f));
+                bodies->rotSpeedZ[i] = 0;
+            }
+            if (contact & wallContactY)
+            {
+                bodies->rotSpeedX[i] = 0;
+                bodies->rotSpeedY[i] = 0;
+                bodies->rotSpeedZ[i] = glm::radians(nextRandomFloat(*random, 3.0f, 4.0f));
+            }
+            if (contact & wallContactZ)
+            {
+                bodies->rotSpeedX[i] = glm::radians(nextRandomFloat(*random, 3.0f, 4.0f));
+                bodies->rotSpeedY[i] = 0;
+                bodies->rotSpeedZ[i] = 0;
+            }
+        }
+
+        // Update the rotation of the awake objects, the sleeping ones don't turn.
+        integrateBodyRotations(*bodies, sleep->awake);
+    }
+}
+
+// This function is to change the internal light of the object randomly.
+float randomLightIntensity(RandomStream & random)
+{
+    float intensity;
+
+    intensity = nextRandom(random) % 3;
+
+    return intensity;
+}
+
+
+// Points the position, UV and normal attributes in the interleaved vertex buffer, which must be bound.
+void setMeshAttributePointers(GLStateCache & state, unsigned int vertexFormat, GLuint positionID, GLuint uvID, GLuint normalID)
+{
+    if (vertexFormat == meshVertexQuantized)
+    {
+        GLsizei stride = sizeof(QuantizedVertex);
+        cachedVertexAttribPointer(state, positionID, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(QuantizedVertex, position));
+        cachedVertexAttribPointer(state, uvID, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(QuantizedVertex, uv));
+        cachedVertexAttribPointer(state, normalID, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(QuantizedVertex, normal));
+    }
+    else
+    {
+        GLsizei stride = sizeof(InterleavedVertex);
+        cachedVertexAttribPointer(state, positionID, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(InterleavedVertex, position));
+        cachedVertexAttribPointer(state, uvID, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(InterleavedVertex, uv));
+        cachedVertexAttribPointer(state, normalID, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(InterleavedVertex, normal));
+    }
+}
+
+int main(void)
+{
+    float lightIntensity = 1;
+    int counter = 2;
+
+    // Initialise GLFW
+    if(!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        getchar();
+        return -1;
+    }
+
+    glfwWindowHint(GLFW_SAMPLES, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+
+    // Open a window and create its OpenGL context
+    window = glfwCreateWindow( 1920, 1080, "Final Project - 4 Objects Random Movement", NULL, NULL);
+    if(window == NULL)
+    {
+        fprintf(stderr, "Failed to open GLFW window.\n");
+        getchar();
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    
+    // Initialize GLEW
+    if (glewInit() != GLEW_OK) 
+    {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        getchar();
+        glfwTerminate();
+        return -1;
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
+    // Hide the mouse and enable unlimited movement
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    
+    // Set the mouse at the center of the screen
+    glfwPollEvents();
+    glfwSetCursorPos(window, 1024/2, 768/2);
+
+    // Black background
+    glClearColor(0.0f, 0.0f, 0.4f, 0.0f);
+
+    // Enable depth test
+    glEnable(GL_DEPTH_TEST);
+    // Accept fragment if it closer to the camera than the former one
+    glDepthFunc(GL_LESS); 
+
+    // Cull triangles which normal is not towards the camera
+    //glEnable(GL_CULL_FACE);
+    glEnable(GL_LIGHTING);
+
+    // Create and compile our GLSL program from the shaders
+    GLuint programID = LoadShaders("StandardShading.vertexshader", "StandardShading.fragmentshader");
+
+    // Get a handle for our "MVP" uniform
+    GLuint MatrixID = glGetUniformLocation(programID, "MVP");
+    GLuint ViewMatrixID = glGetUniformLocation(programID, "V");
+    GLuint ModelMatrixID = glGetUniformLocation(programID, "M");
+
+    // Get a handle for our "JustGreen" and "LightComponent" uniform to control the light on the objects and the color of the xy-plane.
+    GLuint JustGreen = glGetUniformLocation(programID, "JustGreen");
+    GLuint LightComponent = glGetUniformLocation(programID, "LightComponent");
+    //GLuint LightPower = glGetUniformLocation(programID, "LightPower");
+    GLuint LightPower2 = glGetUniformLocation(programID, "LightPower2");
+    glUseProgram(programID);
+
+    // Get a handle for our buffers
+    GLuint vertexPosition_modelspaceID = glGetAttribLocation(programID, "vertexPosition_modelspace");
+    GLuint vertexUVID = glGetAttribLocation(programID, "vertexUV");
+    GLuint vertexNormal_modelspaceID = glGetAttribLocation(programID, "vertexNormal_modelspace");
+
+    // The instanced program draws all objects with one call. The GL 2.1 context only has it through extensions,
+    // so without them the objects are drawn one by one with programID.
+    bool useInstancing = isInstancingSupported();
+    GLuint instancedProgramID = 0;
+    if (useInstancing)
+    {
+        instancedProgramID = LoadShaders("StandardShadingInstanced.vertexshader", "StandardShading.fragmentshader");
+        useInstancing = (instancedProgramID != 0);
+    }
+    printf("Drawing the objects %s\n", useInstancing ? "with one instanced call" : "one by one");
+
+    // Get a handle for the uniforms and the attributes of the instanced program
+    GLuint InstancedViewMatrixID = 0, InstancedLightID = 0, InstancedTextureID = 0, InstancedJustGreen = 0;
+    GLuint instancedPositionID = 0, instancedUVID = 0, instancedNormalID = 0;
+    InstanceAttributes instanceAttributes;
+    if (useInstancing)
+    {
+        InstancedViewMatrixID = glGetUniformLocation(instancedProgramID, "V");
+        InstancedLightID = glGetUniformLocation(instancedProgramID, "LightPosition_worldspace");
+        InstancedTextureID = glGetUniformLocation(instancedProgramID, "myTextureSampler");
+        InstancedJustGreen = glGetUniformLocation(instancedProgramID, "JustGreen");
+        instancedPositionID = glGetAttribLocation(instancedProgramID, "vertexPosition_modelspace");
+        instancedUVID = glGetAttribLocation(instancedProgramID, "vertexUV");
+        instancedNormalID = glGetAttribLocation(instancedProgramID, "vertexNormal_modelspace");
+        getInstanceAttributes(instancedProgramID, instanceAttributes);
+    }
+
+    // Load the texture for the object.
+    GLuint Texture = loadDDS("uvmap.DDS");
+
+    // Load the texture for the floor.
+    GLuint Texture2 = loadBMP_custom("spooky.bmp");
+    
+    // Get a handle for our "myTextureSampler" uniform
+    GLuint TextureID  = glGetUniformLocation(programID, "myTextureSampler");
+
+    // Threads which help the physics thread with the contacts, one per core left. They also build the BVH of the mesh.
+    TaskPool pool;
+    startTaskPool(pool, 0);
+
+    // Read the mesh from its cache, or build the cache from the .obj file.
+    // Quantized vertices need GL_INT_2_10_10_10_REV, which a 2.1 context only has with this extension.
+    bool quantizedSupported = GLEW_ARB_vertex_type_2_10_10_10_rev;
+
+    CachedMesh cachedMesh;
+    MeshSourceKey sourceKey;
+    std::vector<InterleavedVertex> interleaved;
+    std::vector<QuantizedVertex> quantized;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned short> shortIndices;
+    std::vector<MeshLod> lods;
+    std::vector<BvhNode> bvhNodes;
+    std::vector<BvhTriangle> bvhTriangles;
+    unsigned int vertexFormat;
+    GLsizei vertexStride;
+    const void * vertexData;
+    GLsizei vertexCount;
+    const void * indexData;
+    GLenum indexType;
+    GLsizei indexCount;
+    bool cached = loadMeshCache(cachedMesh, "suzanne.obj", sourceKey);
+    if ((cached && cachedMesh.vertexFormat == meshVertexFloat && cachedMesh.vertexStride == sizeof(InterleavedVertex)) ||
+        (cached && cachedMesh.vertexFormat == meshVertexQuantized && cachedMesh.vertexStride == sizeof(QuantizedVertex) && quantizedSupported))
+    {
+        vertexFormat = cachedMesh.vertexFormat;
+        vertexStride = cachedMesh.vertexStride;
+        vertexData = cachedMesh.vertexData;
+        vertexCount = cachedMesh.vertexCount;
+        indexData = cachedMesh.indexData;
+        indexType = cachedMesh.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        indexCount = cachedMesh.indexCount;
+        lods.assign(cachedMesh.lods, cachedMesh.lods + cachedMesh.lodCount);
+        bvhNodes.assign(cachedMesh.bvh.nodes, cachedMesh.bvh.nodes + cachedMesh.bvh.nodeCount);
+        bvhTriangles.assign(cachedMesh.bvh.triangles, cachedMesh.bvh.triangles + cachedMesh.bvh.triangleCount);
+    }
+    else
+    {
+        // Read our .obj file
+        std::vector<glm::vec3> vertices;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        if (!loadOBJ("suzanne.obj", vertices, uvs, normals))
+        {
+            fprintf(stderr, "Failed to load suzanne.obj\n");
+            getchar();
+            stopTaskPool(pool);
+            glfwTerminate();
+            return -1;
+        }
+        if (!indexVBO_interleaved(vertices, uvs, normals, indices, interleaved))
+        {
+            fprintf(stderr, "suzanne.obj has more unique vertices than 32-bit indices can address\n");
+            getchar();
+            stopTaskPool(pool);
+            glfwTerminate();
+            return -1;
+        }
+
+        // Build the levels of detail, each ordered for the post-transform cache of the GPU,
+        // then sort the vertices in the order level 0 fetches them.
+        std::vector<unsigned int> meshIndices;
+        meshIndices.swap(indices);
+        buildLodChain(meshIndices, interleaved, maxLodCount, optimizeMeshForVertexCache, indices, lods);
+        if (optimizeMeshForVertexCache)
+        {
+            VertexCacheStats before = analyzeVertexCache(meshIndices, interleaved.size(), vertexCacheSize);
+            optimizeVertexFetch(indices, interleaved);
+            std::vector<unsigned int> lod0(indices.begin(), indices.begin() + lods[0].indexCount);
+            VertexCacheStats after = analyzeVertexCache(lod0, interleaved.size(), vertexCacheSize);
+            printf("Vertex cache : ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr);
+        }
+        for (unsigned int l = 0; l < lods.size(); l++)
+        {
+            printf("LOD %u : %u triangles, error %.3f\n", l, lods[l].indexCount / 3, lods[l].error);
+        }
+
+        // The BVH of level 0, for the collisions between the meshes.
+        buildMeshBvh(pool, &interleaved[0], sizeof(InterleavedVertex), &indices[0], lods[0].indexCount, bvhNodes, bvhTriangles);
+        printf("BVH : %u nodes over %u triangles\n", (unsigned int)bvhNodes.size(), (unsigned int)bvhTriangles.size());
+
+        // Quantized vertices take 20 bytes instead of 32, if the UVs fit in them.
+        if (quantizedSupported && quantizeVBO(interleaved, quantized))
+        {
+            vertexFormat = meshVertexQuantized;
+            vertexStride = sizeof(QuantizedVertex);
+            vertexData = &quantized[0];
+        }
+        else
+        {
+            vertexFormat = meshVertexFloat;
+            vertexStride = sizeof(InterleavedVertex);
+            vertexData = &interleaved[0];
+        }
+        vertexCount = interleaved.size();
+        saveMeshCache("suzanne.obj", sourceKey, vertexFormat, vertexStride, vertexCount, vertexData, indices, lods, bvhNodes, bvhTriangles);
+
+        // Use 16-bit indices when every index fits, they take half the memory and bandwidth of 32-bit ones.
+        if (narrowIndices(indices, shortIndices))
+        {
+            indexData = &shortIndices[0];
+            indexType = GL_UNSIGNED_SHORT;
+        }
+        else
+        {
+            indexData = &indices[0];
+            indexType = GL_UNSIGNED_INT;
+        }
+        indexCount = indices.size();
+    }
+
+    // Load it into a VBO : positions, UVs and normals interleaved in one buffer.
+    GLuint vertexbuffer;
+    glGenBuffers(1, &vertexbuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * vertexStride, vertexData, GL_STATIC_DRAW);
+
+    // Generate a buffer for the indices as well
+    GLuint elementbuffer;
+    glGenBuffers(1, &elementbuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+    GLsizei indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * indexSize, indexData, GL_STATIC_DRAW);
+
+    // Every object is culled as a sphere of this radius around its position.
+    float boundingRadius = computeBoundingRadius(vertexData, vertexStride, vertexCount);
+
+    // The objects collide as their meshes, tested after the bounding sphere and the oriented box of the mesh.
+    // The core is the largest sphere around the model origin which stays inside the box.
+    CollisionShape shape;
+    shape.box = computeMeshOBB(vertexData, vertexStride, vertexCount);
+    shape.bvh = getMeshBvh(bvhNodes, bvhTriangles);
+    shape.radius = boundingRadius;
+    shape.coreRadius = boundingRadius;
+    for (int a = 0; a < 3; a++)
+    {
+        float inside = shape.box.halfExtents[a] - std::fabs(glm::dot(shape.box.center, shape.box.axes[a]));
+        shape.coreRadius = std::max(std::min(shape.coreRadius, inside), 0.0f);
+    }
+
+    // The data is in the VBOs now.
+    closeMeshCache(cachedMesh);
+
+    // The matrices and the internal light of every visible object, rebuilt every frame.
+    // instanceBodies is the object of every instance : the visible objects, grouped by level of detail.
+    GLuint instancebuffer;
+    glGenBuffers(1, &instancebuffer);
+    std::vector<InstanceData> instances(objCount);
+    std::vector<unsigned int> instanceBodies(objCount);
+
+    // Level of detail of each object, chosen every frame.
+    std::vector<int> bodyLod(objCount, 0);
+
+    // The objects inside the view frustum, found every frame. Sized for the padding of a BodyStore,
+    // which the culling reads four objects at a time.
+    std::vector<unsigned int> visibleBodies((objCount + bodyLanes - 1) / bodyLanes * bodyLanes);
+
+    // The coordinates for the textured image.
+    static const GLfloat g_vertex_buffer_data[] = 
+    {
+        15.0f, -15.0f, 0.0f,  
+        -15.0f, -15.0f, 0.0f, 
+        -15.0f, 15.0f, 0.0f,  
+        15.0f, -15.0f, 0.0f,  
+        15.0f, 15.0f, 0.0f,   
+        -15.0f, 15.0f, 0.0f,  
+    };
+
+    // The UV coordinates for the textured image.
+    static const GLfloat g_uv_buffer_data[] = 
+    {
+        1.0f, 0.0f,	
+        0.0f, 0.0f,  	
+   	    0.0f, 1.0f,
+        1.0f, 0.0f,
+        1.0f, 1.0f,
+        0.0f, 1.0f
+    };
+
+    // Generate and store the coordinates for the floor with a textured image.
+    GLuint vertexbuffer2;
+    glGenBuffers(1, &vertexbuffer2);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer2);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data), g_vertex_buffer_data, GL_STATIC_DRAW);
+
+    // Generate and store the UV coordinates for the floor with a textured image.
+    GLuint uvbuffer2;
+	glGenBuffers(1, &uvbuffer2);
+	glBindBuffer(GL_ARRAY_BUFFER, uvbuffer2);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_uv_buffer_data), g_uv_buffer_data, GL_STATIC_DRAW);
+
+
+    // Get a handle for our "LightPosition" uniform
+    glUseProgram(programID);
+    GLuint LightID = glGetUniformLocation(programID, "LightPosition_worldspace");
+    GLuint LightID2 = glGetUniformLocation(programID, "LightPosition_worldspace2");
+
+    // Initialize 4 objects initial positions, rotations, and their random speed.
+    printf("Random seed %u\n", simulationSeed);
+    RandomStream initialRandom;
+    initRandomStream(initialRandom, simulationSeed, initialStream);
+    BodyStore bodies;
+    initBodyStore(bodies, objCount);
+    const float initialPosition[4][3] = {{4, 0, 3}, {-4, 0, 3}, {0, 4, 3}, {0, -4, 3}};
+    // The first 4 objects face away from the center, the others face -y. All of them keep their top up (+z).
+    const float initialDirection[4][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}};
+
+    // Any object past the first 4 starts at a random position inside the walls.
+    if (objCount > 4)
+    {
+        fillRandomFloats(initialRandom, bodies.posX + 4, objCount - 4, xNegativeWall, xPositiveWall);
+        fillRandomFloats(initialRandom, bodies.posY + 4, objCount - 4, yNegativeWall, yPositiveWall);
+        fillRandomFloats(initialRandom, bodies.posZ + 4, objCount - 4, zNegativeWall, zPositiveWall);
+    }
+
+    for (int i = 0; i < objCount; ++i)
+    {
+        if (i < 4)
+        {
+            bodies.posX[i] = initialPosition[i][0];
+            bodies.posY[i] = initialPosition[i][1];
+            bodies.posZ[i] = initialPosition[i][2];
+            setBodyOrientation(bodies, i, LookAt(glm::vec3(initialDirection[i][0], initialDirection[i][1], initialDirection[i][2]),
+                                                 glm::vec3(0.0f, 0.0f, 1.0f)));
+        }
+        else
+        {
+            setBodyOrientation(bodies, i, LookAt(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+        }
+    }
+
+    // The arrays of the BodyStore are contiguous, so each random attribute is filled in one call.
+    fillRandomFloats(initialRandom, bodies.velX, objCount, -xSpeedScale, xSpeedScale);
+    fillRandomFloats(initialRandom, bodies.velY, objCount, -ySpeedScale, ySpeedScale);
+    fillRandomFloats(initialRandom, bodies.velZ, objCount, zSpeedScale, 2 * zSpeedScale);
+    fillRandomFloats(initialRandom, bodies.rotSpeedZ, objCount, glm::radians(1.0f), glm::radians(2.0f));
+    for (int i = 0; i < objCount; ++i) 
+    {
+        bodies.invMass[i] = 1.0f / bodyMass;
+        bodies.rotSpeedX[i] = 0;
+        bodies.rotSpeedY[i] = 0;
+    }
+
+    // The grid of the broad phase covers the space bounded by the walls.
+    SpatialGrid grid;
+    initSpatialGrid(grid, glm::vec3(xNegativeWall, yNegativeWall, zNegativeWall), glm::vec3(xPositiveWall, yPositiveWall, zPositiveWall), 2.0f * shape.radius);
+
+    // The calculation of the kinematics of objects is conducted by a thread which lives until the window is closed.
+    PhysicsWorker worker;
+    // The thread draws its random numbers from its own stream, in the order of the steps, so a run is the same every time.
+    RandomStream physicsRandom;
+    initRandomStream(physicsRandom, simulationSeed, physicsStream);
+
+    // Every object starts awake.
+    SleepState sleep;
+    initSleepState(sleep, bodies);
+    startPhysicsWorker(worker, bodies, [&shape, &grid, &pool, &physicsRandom, &sleep](BodyStore * state, int move)
+    {
+        kinematicTrajectory(state, &shape, &grid, &pool, &physicsRandom, &sleep, move);
+    });
+
+    // The flickering of the internal lights uses the main thread's own stream.
+    RandomStream lightRandom;
+    initRandomStream(lightRandom, simulationSeed, lightStream);
+
+    // Clock of the fixed steps. accumulator is the time not simulated yet, always less than one step.
+    double lastTime = glfwGetTime();
+    double accumulator = 0.0;
+    unsigned int requestedSteps = 0;
+
+    // The objects as they are drawn : between the last two steps of the simulation.
+    BodyStore renderBodies;
+    initBodyStore(renderBodies, objCount);
+
+    // The GL calls of the frames go through the cache, which skips the ones that would change nothing.
+    GLStateCache glState;
+    initGLStateCache(glState);
+    double lastReportTime = lastTime;
+
+    do
+    {
+        // This statement is used to change the light intensity randomly but make sure that 
+        // the frequency of change is not too fast.
+        if (moveControl != 0)
+        {
+            counter--;
+            if (counter == 0)
+            {
+                lightIntensity = randomLightIntensity(lightRandom);
+                counter = 2;
+            }
+        }
+
+        // The objects are drawn one step behind the simulated time of the last frame.
+        // The snapshot taken below holds at best the steps the last frame asked for, so this is the latest time
+        // with a step on both sides of it. The delay is one frame plus one step, the same for every frame,
+        // so the objects move evenly whatever the ratio between the frame rate and the steps.
+        double renderStep = requestedSteps + accumulator / physicsTimeStep - 1.0;
+
+        // Run as many fixed steps as the time since the last frame holds.
+        double currentTime = glfwGetTime();
+        accumulator += currentTime - lastTime;
+        lastTime = currentTime;
+
+        int steps = (int)(accumulator / physicsTimeStep);
+        if (steps > maxSubsteps)
+        {
+            steps = maxSubsteps;
+            accumulator = steps * physicsTimeStep;
+        }
+        accumulator -= steps * physicsTimeStep;
+
+        // Take the latest state calculated by the thread, and let the thread calculate 
+        // the next steps while this one is rendered. If the thread is too far behind,
+        // it drops the steps it can't take, like the clamp above drops the time.
+        const PhysicsSnapshot & snapshot = acquireFrontSnapshot(worker);
+        if (steps > 0)
+        {
+            requestedSteps += requestPhysicsSteps(worker, moveControl, steps, maxSubsteps);
+        }
+
+        // If the thread has not caught up yet, the objects stay on its latest step.
+        float alpha = (float)(renderStep - (snapshot.step - 1.0));
+        alpha = glm::clamp(alpha, 0.0f, 1.0f);
+        interpolateBodies(renderBodies, snapshot.previous, snapshot.current, alpha);
+
+        // Once a second, report how many GL calls of the last frame were sent and how many the cache skipped.
+        beginGLStateFrame(glState);
+        if (currentTime - lastReportTime >= 1.0)
+        {
+            printf("GL calls per frame : %u sent, %u skipped\n", glState.lastFrame.issued, glState.lastFrame.elided);
+            lastReportTime = currentTime;
+        }
+
+        // Clear the screen
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+
+        // Compute the MVP matrix from keyboard and mouse input
+        computeMatricesFromInputs();
+        
+        glm::mat4 ProjectionMatrix = getProjectionMatrix();
+        glm::mat4 ViewMatrix = getViewMatrix();
+        glm::mat4 VP = ProjectionMatrix * ViewMatrix;
+        cachedUseProgram(glState, programID);
+
+        glm::vec3 lightPos = glm::vec3(0,0,25);
+        cachedUniform3f(glState, LightID, lightPos.x, lightPos.y, lightPos.z);
+
+        cachedUniformMatrix4fv(glState, ViewMatrixID, &ViewMatrix[0][0]); // This one doesn't change between objects, so this can be done once for all objects that use "programID"
+
+        // Bind our texture in Texture Unit 0
+        cachedActiveTexture(glState, GL_TEXTURE0);
+        cachedBindTexture2D(glState, Texture);
+        // Set our "myTextureSampler" sampler to user Texture Unit 0
+        cachedUniform1i(glState, TextureID, 0);
+
+        // Only the objects the camera can see are drawn.
+        Frustum frustum;
+        extractFrustumPlanes(VP, frustum);
+        unsigned int visibleCount = cullSpheres(frustum, renderBodies.posX, renderBodies.posY, renderBodies.posZ,
+                                                objCount, boundingRadius, &visibleBodies[0]);
+
+        // Pick the level of detail of each visible object from its distance to the camera
+        // and the size of its simplification error on the screen.
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        float pixelsPerUnit = framebufferHeight * 0.5f * ProjectionMatrix[1][1];
+        glm::vec3 cameraPos = getCameraPosition();
+        for (unsigned int v = 0; v < visibleCount; v++)
+        {
+            int i = visibleBodies[v];
+            float distance = glm::length(getBodyPosition(renderBodies, i) - cameraPos);
+            bodyLod[i] = selectLod(&lods[0], lods.size(), distance, pixelsPerUnit, lodPixelError);
+        }
+
+        if (useInstancing && visibleCount > 0)
+        {
+            ////// Start of the instanced rendering of the objects //////
+
+            // The instances are grouped by level of detail, so each level is one draw call.
+            unsigned int lodStart[maxLodCount + 1] = {0};
+            for (unsigned int v = 0; v < visibleCount; v++)
+            {
+                lodStart[bodyLod[visibleBodies[v]] + 1]++;
+            }
+            for (int l = 0; l < maxLodCount; l++)
+            {
+                lodStart[l + 1] += lodStart[l];
+            }
+            unsigned int lodFill[maxLodCount];
+            std::copy(lodStart, lodStart + maxLodCount, lodFill);
+            for (unsigned int v = 0; v < visibleCount; v++)
+            {
+                int i = visibleBodies[v];
+                instanceBodies[lodFill[bodyLod[i]]++] = i;
+            }
+
+            // The instances are built straight into the buffer.
+            InstanceData * mappedInstances = mapInstances(glState, instancebuffer, visibleCount);
+            if (mappedInstances != NULL)
+            {
+                buildInstances(pool, renderBodies, &instanceBodies[0], visibleCount, VP, lightIntensity, mappedInstances);
+            }
+            if (mappedInstances == NULL || !unmapInstances(glState, instancebuffer))
+            {
+                instances.resize(visibleCount);
+                buildInstances(pool, renderBodies, &instanceBodies[0], visibleCount, VP, lightIntensity, &instances[0]);
+                uploadInstances(glState, instancebuffer, instances);
+            }
+
+            cachedUseProgram(glState, instancedProgramID);
+            cachedUniformMatrix4fv(glState, InstancedViewMatrixID, &ViewMatrix[0][0]);
+            cachedUniform3f(glState, InstancedLightID, lightPos.x, lightPos.y, lightPos.z);
+            cachedUniform1i(glState, InstancedTextureID, 0);
+            cachedUniform1i(glState, InstancedJustGreen, 0);
+
+            cachedEnableVertexAttribArray(glState, instancedPositionID);
+            cachedEnableVertexAttribArray(glState, instancedUVID);
+            cachedEnableVertexAttribArray(glState, instancedNormalID);
+            cachedBindBuffer(glState, GL_ARRAY_BUFFER, vertexbuffer);
+            setMeshAttributePointers(glState, vertexFormat, instancedPositionID, instancedUVID, instancedNormalID);
+
+            // Draw the triangles of all objects, one level of detail at a time !
+            cachedBindBuffer(glState, GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+            for (unsigned int l = 0; l < lods.size(); l++)
+            {
+                GLsizei count = lodStart[l + 1] - lodStart[l];
+                if (count == 0)
+                {
+                    continue;
+                }
+                bindInstanceAttributes(glState, instancebuffer, instanceAttributes, lodStart[l]);
+                glDrawElementsInstancedARB(GL_TRIANGLES, lods[l].indexCount, indexType, (void*)(size_t)(lods[l].firstIndex * indexSize), count);
+            }
+
+            unbindInstanceAttributes(glState, instanceAttributes);
+            cachedDisableVertexAttribArray(glState, instancedPositionID);
+            cachedDisableVertexAttribArray(glState, instancedUVID);
+            cachedDisableVertexAttribArray(glState, instancedNormalID);
+
+            // Back to the program of the floor. The floor is also lit by the internal light of the last object,
+            // like when the objects are drawn one by one.
+            cachedUseProgram(glState, programID);
+            glm::vec3 lastPos = getBodyPosition(renderBodies, objCount - 1);
+            cachedUniform3f(glState, LightID2, lastPos.x, lastPos.y, lastPos.z);
+            cachedUniform1f(glState, LightPower2, lightIntensity);
+            cachedEnableVertexAttribArray(glState, vertexPosition_modelspaceID);
+            cachedEnableVertexAttribArray(glState, vertexUVID);
+            cachedEnableVertexAttribArray(glState, vertexNormal_modelspaceID);
+
+            ////// End of the instanced rendering of the objects //////
+        }
+        else
+        {
+            // Also taken when no object is visible : the loop below draws nothing and the floor is drawn as usual.
+            cachedEnableVertexAttribArray(glState, vertexPosition_modelspaceID);
+            cachedEnableVertexAttribArray(glState, vertexUVID);
+            cachedEnableVertexAttribArray(glState, vertexNormal_modelspaceID);
+
+            ////// Start of the rendering of the objects //////
+
+            // The matrices of all visible objects are built at once, in the order of visibleBodies.
+            instances.resize(visibleCount);
+            if (visibleCount > 0)
+            {
+                buildInstances(pool, renderBodies, &visibleBodies[0], visibleCount, VP, lightIntensity, &instances[0]);
+            }
+
+            for (unsigned int v = 0; v < visibleCount; v++)
+            {
+                int i = visibleBodies[v];
+                const InstanceData & instance = instances[v];
+
+                // Send our transformation to the currently bound shader, in the "MVP" uniform
+                cachedUniformMatrix4fv(glState, MatrixID, &instance.mvp[0][0]);
+                cachedUniformMatrix4fv(glState, ModelMatrixID, &instance.model[0][0]);
+
+                // Change the internal light's intensity randomly for the object.
+                cachedUniform3f(glState, LightID2, instance.light.x, instance.light.y, instance.light.z);
+                cachedUniform1f(glState, LightPower2, instance.light.w);
+
+                // Positions, UVs and normals, all in the interleaved buffer
+                cachedBindBuffer(glState, GL_ARRAY_BUFFER, vertexbuffer);
+                setMeshAttributePointers(glState, vertexFormat, vertexPosition_modelspaceID, vertexUVID, vertexNormal_modelspaceID);
+
+                // Index buffer
+                cachedBindBuffer(glState, GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
+
+                // Draw the triangles of its level of detail !
+                const MeshLod & lod = lods[bodyLod[i]];
+                cachedUniform1i(glState, JustGreen, 0);
+                glDrawElements
+                (
+                    GL_TRIANGLES,                                 // mode
+                    lod.indexCount,                               // count
+                    indexType,                                    // type
+                    (void*)(size_t)(lod.firstIndex * indexSize)   // element array buffer offset
+                );
+            }
+
+            ////// End of rendering of the objects //////
+        }
+
+
+        ////// Start of the rendering of the textured floor //////
+
+        // Set the kinetic matrix of the floor.
+        glm::mat4 ModelMatrix = glm::mat4(1.0);
+        glm::mat4 MVP = VP * ModelMatrix;
+        cachedUniformMatrix4fv(glState, MatrixID, &MVP[0][0]);
+        cachedUniformMatrix4fv(glState, ModelMatrixID, &ModelMatrix[0][0]);
+
+        // added Bind our texture in Texture Unit 1
+        cachedActiveTexture(glState, GL_TEXTURE1);
+        cachedBindTexture2D(glState, Texture2);
+        // added Set our "myTextureSampler" sampler to user Texture Unit 0
+        cachedUniform1i(glState, TextureID, 1);
+
+        cachedBindBuffer(glState, GL_ARRAY_BUFFER, vertexbuffer2);
+        cachedVertexAttribPointer(glState, vertexPosition_modelspaceID, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+        // added 2nd attribute buffer : UVs
+        cachedBindBuffer(glState, GL_ARRAY_BUFFER, uvbuffer2);
+        cachedVertexAttribPointer(glState, vertexUVID, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+        // The floor has no normal buffer : the normal array is turned off and every vertex gets the same normal, up.
+        // Left on, it would read from whatever buffer the objects' draws last pointed it at.
+        cachedDisableVertexAttribArray(glState, vertexNormal_modelspaceID);
+        glVertexAttrib3f(vertexNormal_modelspaceID, 0.0f, 0.0f, 1.0f);
+
+        // Draw the triangleS !
+        cachedUniform1i(glState, JustGreen, 0);
+        glDrawArrays(GL_TRIANGLES, 0, 2*3);
+
+        ////// End of rendering of the xy-plane object //////
+
+        cachedDisableVertexAttribArray(glState, vertexPosition_modelspaceID);
+        cachedDisableVertexAttribArray(glState, vertexUVID);
+        cachedDisableVertexAttribArray(glState, vertexNormal_modelspaceID);
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+
+    } // Check if the ESC key was pressed or the window was closed
+    while (glfwGetKey(window, GLFW_KEY_ESCAPE ) != GLFW_PRESS && glfwWindowShouldClose(window) == 0);
+
+    stopPhysicsWorker(worker);
+    stopTaskPool(pool);
+
+    // Cleanup VBO and shader
+    glDeleteBuffers(1, &vertexbuffer);
+    glDeleteBuffers(1, &elementbuffer);
+    glDeleteBuffers(1, &vertexbuffer2);
+    glDeleteBuffers(1, &uvbuffer2);
+    glDeleteBuffers(1, &instancebuffer);
+    if (instancedProgramID != 0)
+    {
+        glDeleteProgram(instancedProgramID);
+    }
+    glDeleteProgram(programID);
+    glDeleteTextures(1, &Texture);
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}